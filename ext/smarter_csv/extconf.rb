@@ -38,6 +38,33 @@ optflags << " -fno-semantic-interposition" if compiler_accepts?("-fno-semantic-i
 
 append_cflags('-Wno-compound-token-split-by-macro')
 
+# parallel: N scans blocks on native threads with the GVL released; without these the
+# extension still builds and parses every block on the calling thread.
+have_header('pthread.h')
+have_func('rb_thread_call_without_gvl', 'ruby/thread.h')
+
+# intern_columns: frozen, deduplicated Strings straight from the field bytes (Ruby 3.0+;
+# older Rubies intern through String#-@)
+have_func('rb_enc_interned_str', 'ruby/encoding.h')
+
+# io_mode: :mmap parses a file straight from a read-only mapping; without mmap it reads
+# through the IO like every other input
+have_header('sys/mman.h')
+have_func('mmap', 'sys/mman.h')
+
+# compression: :gzip inflates with zlib in C; without it the Reader uses Zlib::GzipReader
+# (HAVE_LIBZ can't be trusted: Ruby's own config.h defines it)
+if have_header('zlib.h') && have_library('z', 'inflateInit2_', 'zlib.h')
+  $defs << '-DSMARTER_CSV_HAVE_ZLIB'
+end
+
+# read_ahead: reads the next blocks of an fd-backed IO on a native thread (needs the
+# pthread support above); without poll the block reader reads on the calling thread
+have_header('poll.h')
+
+# result_format: :columnar exports int64/float64 columns through the MemoryView API (Ruby 3.0+)
+have_header('ruby/memory_view.h')
+
 CONFIG["optflags"] = optflags
 CONFIG["debugflags"] = ""
 
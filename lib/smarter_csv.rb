@@ -2,18 +2,22 @@
 
 require 'stringio'
 require 'bigdecimal' # for decimal_precision: :auto / :bigdecimal
+require 'date' # for infer_types date columns
 require "smarter_csv/version"
 require "smarter_csv/errors"
 
 require "smarter_csv/file_io"
 require "smarter_csv/auto_detection" # MAX_AUTO_ROW_SEP_CHARS is the canonical 64KB cap; loaded first so peekable_io.rb and reader_options.rb can reference it
 require "smarter_csv/peekable_io"
+require "smarter_csv/row_index"
+require "smarter_csv/checkpoint"
 require "smarter_csv/reader_options"
 require "smarter_csv/writer_options"
 require 'smarter_csv/header_transformations'
 require 'smarter_csv/header_validations'
 require "smarter_csv/headers"
 require "smarter_csv/hash_transformations"
+require "smarter_csv/type_inference"
 
 require "smarter_csv/parser"
 require "smarter_csv/writer"
@@ -150,6 +154,19 @@ module SmarterCSV
     end
   end
 
+  # Writes a row-offset index of a CSV file to a sidecar file (`<path>.csvidx`) and returns
+  # its path. Reading a slice of rows with the index seeks close to the first one instead of
+  # parsing the file from the start. Pass the options the file is read with; the index is
+  # only used while the file, its header and those options are unchanged.
+  #
+  # Example:
+  #   SmarterCSV.build_index("big.csv", col_sep: ";")
+  #   SmarterCSV.process("big.csv", col_sep: ";", index: true, rows: 5_000_000..5_099_999)
+  #
+  def self.build_index(path, options = {})
+    Reader.new(path, options).build_index
+  end
+
   # Returns the errors from the most recent call to .process, .parse, .each, or .each_chunk
   # on the current thread. Cleared at the start of each new call.
   #
@@ -0,0 +1,61 @@
+# frozen_string_literal: true
+
+module SmarterCSV
+  # Where a chunked read of a seekable input stands after a chunk: the byte offset of the
+  # next row, the line counters, the headers (with generated extra columns), the separators
+  # and the chunk count. A run killed half-way can continue from the last chunk it finished:
+  #
+  #   reader = SmarterCSV::Reader.new('big.csv', chunk_size: 1_000, resume_from: saved_token)
+  #   reader.each_chunk do |chunk, index|
+  #     import(chunk)
+  #     save(reader.checkpoint.dump)
+  #   end
+  #
+  # #dump is a JSON String; resume_from: takes it or a Checkpoint.
+  class Checkpoint
+    VERSION = 1
+
+    attr_reader :offset, :file_line_count, :csv_line_count, :chunk_count, :headers, :raw_header,
+                :row_sep, :col_sep, :inferred_types
+
+    def self.load(token)
+      return token if token.is_a?(Checkpoint)
+
+      require 'json'
+      data = JSON.parse(token)
+      raise SmarterCSV::IncorrectOption, "unsupported checkpoint version #{data['version'].inspect}" unless data['version'] == VERSION
+
+      headers = data['headers'].map { |h| h.is_a?(Hash) ? h['symbol'].to_sym : h }
+      types = headers.zip(data['types']).filter_map { |h, t| [h, t.to_sym] if t }.to_h if data['types']
+      new(offset: data['offset'], file_line_count: data['file_line_count'], csv_line_count: data['csv_line_count'],
+          chunk_count: data['chunk_count'], headers: headers, raw_header: data['raw_header'],
+          row_sep: data['row_sep'], col_sep: data['col_sep'], inferred_types: types)
+    rescue JSON::ParserError, NoMethodError, TypeError => e
+      raise SmarterCSV::IncorrectOption, "invalid checkpoint: #{e.message}"
+    end
+
+    def initialize(offset:, file_line_count:, csv_line_count:, chunk_count:, headers:, raw_header:, row_sep:, col_sep:, inferred_types: nil)
+      @offset = offset
+      @file_line_count = file_line_count
+      @csv_line_count = csv_line_count
+      @chunk_count = chunk_count
+      @headers = headers
+      @raw_header = raw_header
+      @row_sep = row_sep
+      @col_sep = col_sep
+      @inferred_types = inferred_types
+    end
+
+    # JSON String; Symbol headers are written as { "symbol": name }
+    def dump
+      require 'json'
+      JSON.generate(
+        version: VERSION, offset: @offset, file_line_count: @file_line_count, csv_line_count: @csv_line_count,
+        chunk_count: @chunk_count, row_sep: @row_sep, col_sep: @col_sep, raw_header: @raw_header&.dup&.force_encoding(Encoding::UTF_8)&.scrub,
+        headers: @headers.map { |h| h.is_a?(Symbol) ? { symbol: h.to_s } : h },
+        types: @inferred_types && @headers.map { |h| @inferred_types[h] }
+      )
+    end
+    alias to_s dump
+  end
+end
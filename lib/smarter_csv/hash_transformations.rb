@@ -8,6 +8,7 @@ module SmarterCSV
     # INTEGER_REGEX = /\A[+-]?\d+\z/.freeze
     ZERO_REGEX = /\A[+-]?0+(?:\.0+)?\z/.freeze # could be +0.0
     EXPONENT_CHARS = %w[e E].freeze # mantissa scan stops here in significant_digits
+    EXPONENT_REGEX = /[eE]/.freeze
 
     # First-byte values that can begin a numeric literal — used to skip the numeric
     # regexes for values that obviously aren't numbers (e.g. city names).
@@ -29,9 +30,11 @@ module SmarterCSV
       nil_values_matching = options[:nil_values_matching]
       convert_to_numeric = options[:convert_values_to_numeric]
       value_converters = options[:value_converters]
+      column_types = options[:_column_types] # infer_types: { header => type } (see TypeInference)
+      intern = options[:intern_columns] # true, or the keys whose Strings are deduplicated with String#-@
 
       # Early return if no transformations needed
-      return hash unless remove_empty_values || remove_zero_values || nil_values_matching || convert_to_numeric || value_converters
+      return hash unless remove_empty_values || remove_zero_values || nil_values_matching || convert_to_numeric || value_converters || column_types || intern
 
       # {only:}/{except:} limits on numeric conversion apply only when the option is a Hash;
       # in the common case (true/false) skip the per-key check entirely.
@@ -63,8 +66,10 @@ module SmarterCSV
           next
         end
 
-        # Convert to numeric if requested
-        if convert_to_numeric && v.is_a?(String) &&
+        # Convert by the inferred column type, or to numeric if requested
+        if column_types && v.is_a?(String) && (type = column_types[k])
+          hash[k] = convert_to_column_type(v, type, options)
+        elsif convert_to_numeric && v.is_a?(String) &&
            (!numeric_has_limits || !limit_execution_for_only_or_except(options, :convert_values_to_numeric, k))
           # Fast-reject: the string is already stripped and NUMERIC_REGEX is \A-anchored on a digit or sign,
           # so a value whose first byte isn't a digit, '+', or '-' cannot be numeric — skip the regex entirely.
@@ -82,6 +87,10 @@ module SmarterCSV
           end
         end
 
+        if intern && (v = hash[k]).is_a?(String) && (intern == true || intern == k || (intern.is_a?(Array) && intern.include?(k)))
+          hash[k] = -v
+        end
+
         # Apply value converters
         if value_converters
           converter = value_converters[k]
@@ -129,14 +138,18 @@ module SmarterCSV
     protected
 
     # Convert a decimal string (has a '.' or an exponent) to a numeric, honoring
-    # decimal_precision: :float -> Float, :bigdecimal -> BigDecimal, :auto -> Float unless
-    # the value carries more than 16 significant digits (then BigDecimal, no precision loss).
+    # decimal_precision: :float -> Float, :bigdecimal -> BigDecimal, :rational -> Rational,
+    # :auto -> Float unless the value carries more than 16 significant digits (then BigDecimal,
+    # no precision loss).
     def convert_decimal(str, decimal_precision)
       case decimal_precision
       when :float
         str.to_f
       when :bigdecimal
         BigDecimal(str)
+      when :rational
+        # String#to_r cannot scale by an exponent past 1_000_000; those stay Float, as in C
+        (e = str.index(EXPONENT_REGEX)) && str[(e + 1)..].to_i.abs > 1_000_000 ? str.to_f : str.to_r
       else # :auto
         # A float token always has a '.' or 'e', so a token of <= 17 bytes holds at most
         # 16 digits and therefore <= 16 significant digits — skip the per-char scan and go
@@ -336,6 +336,22 @@ module SmarterCSV
       @buffer_frozen = true
     end
 
+    # Hands out the bytes still buffered (raw, in the external encoding) and marks the
+    # buffer exhausted, so that what follows comes straight from #source. Used by
+    # read_ahead, which reads the source's file descriptor on a native thread.
+    def drain_buffer
+      return ''.b if buffer_exhausted?
+
+      rest = @peek_buf.byteslice(@peek_pos..-1).b
+      @peek_pos = @peek_buf.bytesize
+      rest
+    end
+
+    # The wrapped IO
+    def source
+      @io
+    end
+
     def close
       @io.close if @io.respond_to?(:close)
     end
@@ -429,7 +445,8 @@ module SmarterCSV
     # PeekableIO is an internal SmarterCSV utility; reader.rb is its only caller.
     # Every method SmarterCSV uses on a PeekableIO is either defined explicitly on
     # this class (peek, gets, read, each_char, readline, eof?, close, rewind_buffer,
-    # freeze_buffer!, external_encoding, internal_encoding) or is on this list.
+    # freeze_buffer!, drain_buffer, source, external_encoding, internal_encoding) or is
+    # on this list.
     #
     # Any other call — seek, pos=, lineno=, ungetc, ungetbyte, readpartial, sysread,
     # readlines, each_line, etc. — raises NoMethodError. That surfaces a future
@@ -11,6 +11,13 @@ module SmarterCSV
     # know to configure it explicitly.
     DEFAULT_CHUNK_SIZE = 100
 
+    # Bytes pulled from the input per #read when the C block reader drives the main loop.
+    BLOCK_READ_SIZE = 256 * 1024
+
+    # Most threads parallel: can ask for (PARALLEL_MAX_THREADS in the C extension); each one
+    # adds BLOCK_READ_SIZE to the block buffer.
+    PARALLEL_MAX_THREADS = 64
+
     include ::SmarterCSV::Reader::Options
     include ::SmarterCSV::FileIO
     include ::SmarterCSV::AutoDetection
@@ -18,12 +25,14 @@ module SmarterCSV
     include ::SmarterCSV::HeaderTransformations
     include ::SmarterCSV::HeaderValidations
     include ::SmarterCSV::HashTransformations
+    include ::SmarterCSV::TypeInference
     include ::SmarterCSV::Parser
 
     attr_reader :input, :options
     attr_reader :csv_line_count, :chunk_count, :file_line_count
     attr_reader :enforce_utf8, :has_rails, :has_rails_logger, :has_acceleration
     attr_reader :errors, :warnings, :headers, :raw_header, :result
+    attr_reader :checkpoint # SmarterCSV::Checkpoint after the last chunk (chunk_size, seekable input)
 
     def self.default_options
       Options::DEFAULT_OPTIONS
@@ -132,19 +141,26 @@ module SmarterCSV
         # input.is_a?(String), which sent Pathname down the IO branch and then called its
         # private Kernel#gets, raising "private method 'gets' called" (issue #337).
         fh = input.respond_to?(:gets) ? input : File.open(input, "r:#{options[:file_encoding]}")
+        fh = gunzip(fh, options) if gzip_input?(fh, options)
 
         # Rewindable inputs (File, Tempfile, StringIO, Zlib::GzipReader, ...) use
         # native rewind for auto-detection — no wrapper overhead in the hot loop.
         # Non-rewindable streams (pipes, STDIN, custom non-seekable IOs) go through
-        # PeekableIO which buffers the first chunk so detection can replay without
-        # seeking the underlying source.
+        # PeekableIO (or its C counterpart StreamBuffer) which buffers the first chunk
+        # so detection can replay without seeking the underlying source.
         has_rewind = seekable?(fh)
 
         unless has_rewind
+          raise SmarterCSV::IncorrectOption, "resume_from needs a seekable input (File, StringIO)" if options[:resume_from]
+
           # buffer_size has been validated and clamped by reader_options.rb to be in
           # [MIN_BUFFER_SIZE, MAX_BUFFER_SIZE], with a cross-validation bump if it was
           # below auto_row_sep_chars. Use it directly.
-          fh = SmarterCSV::PeekableIO.new(fh, options, buffer_size: options[:buffer_size])
+          fh = if stream_buffer?(fh, options)
+                 SmarterCSV::Parser.new_stream_buffer_c(fh, options[:buffer_size])
+               else
+                 SmarterCSV::PeekableIO.new(fh, options, buffer_size: options[:buffer_size])
+               end
         end
 
         if (options[:force_utf8] || options[:file_encoding] =~ /utf-8/i) && (fh.respond_to?(:external_encoding) && fh.external_encoding != Encoding.find('UTF-8') || fh.respond_to?(:encoding) && fh.encoding != Encoding.find('UTF-8'))
@@ -155,45 +171,24 @@ module SmarterCSV
           end
         end
 
-        # Auto-detection. Two orchestrations, same detection functions:
-        #   has_rewind=true  → native fh.rewind between passes; BOM is stripped by
-        #                      next_line_with_counts on the first real line.
-        #   has_rewind=false → PeekableIO buffers the first chunk; peek strips BOM,
-        #                      rewind_buffer replays, freeze_buffer! locks the buffer.
-        if options[:row_sep]&.to_sym == :auto || options[:col_sep]&.to_sym == :auto
-          if has_rewind
-            options[:row_sep] = guess_line_ending(fh, options) if options[:row_sep]&.to_sym == :auto
-            fh.rewind
-            @file_line_count = 0
-            @csv_line_count = 0
-            # skip_lines feeds clean data lines to guess_column_separator. When col_sep is
-            # explicit, it's wasted work — the bytes are consumed and rewound. Guard it.
-            skip_lines(fh, options) if options[:skip_lines] && options[:col_sep]&.to_sym == :auto
-            options[:col_sep] = guess_column_separator(fh, options) if options[:col_sep]&.to_sym == :auto
-            fh.rewind
-            @file_line_count = 0
-            @csv_line_count = 0
-          else
-            fh.peek
-            options[:row_sep] = guess_line_ending(fh, options) if options[:row_sep]&.to_sym == :auto
-            rewind_buffer(fh)
-            skip_lines(fh, options) if options[:skip_lines] && options[:col_sep]&.to_sym == :auto
-            options[:col_sep] = guess_column_separator(fh, options) if options[:col_sep]&.to_sym == :auto
-            fh.freeze_buffer!
-            rewind_buffer(fh)
-          end
+        # resume_from: continue where a checkpoint was taken — the separators and headers come
+        # from it, so auto-detection and the header line are skipped.
+        if options[:resume_from]
+          resumed_chunks = resume_from_checkpoint(fh, options)
+        else
+          detect_and_read_headers(fh, has_rewind, options)
         end
-
-        skip_lines(fh, options) if options[:skip_lines] # skip comments
-
-        # NOTE: we are no longer using header_size
-        @headers, _header_size = process_headers(fh, options)
         @headerA = @headers # @headerA is deprecated, use @headers
 
         $stderr.puts "Effective headers:\n#{pp(@headers)}\n" if @verbose == :debug
 
         header_validations(@headers, options)
 
+        # rows: a range of data rows. With index: the reader first seeks to the indexed row
+        # at or before its start; the rows up to it are still parsed (a multiline row has to
+        # be stitched to be skipped) but dropped, and reading stops after its end.
+        rows_first, rows_last = rows_window(fh, options) if options[:rows]
+
         # Precompute column filter sets for only_headers / except_headers (O(1) lookup per row)
         @only_headers_set   = options[:only_headers]   ? Set.new(options[:only_headers])   : nil
         @except_headers_set = options[:except_headers] ? Set.new(options[:except_headers]) : nil
@@ -241,6 +236,22 @@ module SmarterCSV
         # first (C downgrades to RFC internally via Opt #5 when no backslash is found).
         @hot_path_options = @quote_escaping_auto ? @quote_escaping_backslash : options
 
+        # Checkpoints need a position to seek back to: a seekable input read without transcoding.
+        @checkpointable = options[:chunk_size].to_i > 0 && !options[:rows] && has_rewind && fh.respond_to?(:seek) &&
+                          fh.respond_to?(:pos) && !(fh.respond_to?(:internal_encoding) && fh.internal_encoding)
+        @checkpoint = nil
+
+        # infer_types: read ahead and type the columns before the parse contexts are built;
+        # the rows read ahead are replayed first by the loop below. date_columns,
+        # time_columns and Symbol value_converters are added to the column types; the
+        # Symbol converters are taken out first, so the sample never calls them.
+        typed_converters = take_typed_converters(options)
+        if options[:infer_types] && !(resumed_chunks && @inferred_types)
+          sample_start = [@file_line_count, @csv_line_count]
+          replay = infer_column_types(fh, options)
+        end
+        store_column_types(options, typed_converters)
+
         # Build ParseContext objects once after headers are known.
         # Eliminates ~10 rb_hash_aref calls per row by pre-baking all loop-invariant
         # options into a C struct accessed via direct pointer dereference.
@@ -249,6 +260,10 @@ module SmarterCSV
           double_opts = @quote_escaping_double
           @parse_ctx        = SmarterCSV::Parser.new_parse_context_c(@headers, hot_opts)
           @parse_ctx_double = SmarterCSV::Parser.new_parse_context_c(@headers, double_opts)
+          # Parse state of a row left open inside a quoted field, one per context, so the
+          # multiline stitch loop continues the scan instead of re-parsing the whole row.
+          @parse_cont        = SmarterCSV::Parser.new_parse_continuation_c
+          @parse_cont_double = SmarterCSV::Parser.new_parse_continuation_c
         end
 
         # Key-cleanup flags — computed once, checked per row via cheap ivar reads.
@@ -257,6 +272,10 @@ module SmarterCSV
         @delete_nil_keys   = !!options[:key_mapping]
         @delete_empty_keys = !!options[:key_mapping] || @headers.include?(:"")
 
+        # rows_as: :arrays — with the C extension the parser builds each row as an Array
+        # indexed like @headers; the Ruby cleanup below then works by position (array_row_plan).
+        @rows_as_arrays = options[:rows_as] == :arrays
+
         # Cache field_size_limit as an ivar (nil when unset → one nil-check per row, no method calls).
         @field_size_limit = options[:field_size_limit]
 
@@ -264,7 +283,7 @@ module SmarterCSV
         if options[:chunk_size].to_i > 0
           use_chunks = true
           chunk_size = options[:chunk_size].to_i
-          @chunk_count = 0
+          @chunk_count = resumed_chunks || 0
           chunk = []
         else
           use_chunks = false
@@ -292,30 +311,92 @@ module SmarterCSV
           on_start.call(input_meta.merge(col_sep: options[:col_sep], row_sep: options[:row_sep]))
         end
 
+        # Block mode: when the C extension can take over reading, it pulls BLOCK_READ_SIZE
+        # bytes per #read and hands back a whole block of parsed rows, so the loop below
+        # no longer pays an IO#gets, a line String and a C call for every physical line.
+        block_reader = new_block_reader(fh, options)
+        @file_line_count, @csv_line_count = sample_start if sample_start
+        block_rows = nil
+        block_idx = block_rows_size = 0
+
+        # result_format: :columnar — process returns { header => column }. With the C extension
+        # the rows are collected by a C column builder, and when a row needs no more Ruby work
+        # after parsing, the block reader appends it straight from the parser (no row Hash).
+        columnar = options[:result_format] == :columnar && !block_given?
+        column_builder = SmarterCSV::Parser.new_column_builder_c if columnar && @use_acceleration
+        direct_columns = column_builder if block_reader && columnar_direct?(options)
+
         # now on to processing all the rest of the lines in the CSV file:
-        while (line = next_line_with_counts(fh, options))
+        while true
+          block_row = false
+          if replay && !replay.empty?
+            # a row read ahead by infer_types: parsed below like one from the line loop
+            line, physical_lines, row_end = replay.shift
+            @csv_line_count += 1
+            @file_line_count += 1
+            bad_row_start_csv_line  = @csv_line_count
+            bad_row_start_file_line = @file_line_count
+            @file_line_count += physical_lines - 1
+            # a multiline row the sample stopped stitching at field_size_limit
+            replay_over_limit = physical_lines > 1 && @field_size_limit && line.bytesize > @field_size_limit
+
+            next if options[:comment_regexp] && line =~ options[:comment_regexp]
+          elsif block_reader
+            block_row = true
+            row_end = nil
+            if block_idx == block_rows_size
+              block_rows = SmarterCSV::Parser.read_block_ctx_c(block_reader, @parse_ctx, @quote_escaping_auto ? @parse_ctx_double : nil, direct_columns)
+              break if block_rows.nil?
+
+              block_idx = 0
+              block_rows_size = block_rows.size
+            end
+            # each row is a [hash, data_size, physical_lines] triple in the flat block Array
+            hash      = block_rows[block_idx]
+            data_size = block_rows[block_idx + 1]
+            @csv_line_count += 1
+            bad_row_start_csv_line  = @csv_line_count
+            bad_row_start_file_line = @file_line_count + 1
+            @file_line_count += block_rows[block_idx + 2]
+            block_idx += 3
+            line = nil
+
+            $stderr.print "processing file line %10d, csv line %10d\r" % [@file_line_count, @csv_line_count] if @verbose == :debug
+          else
+            row_end = nil
+            line = next_line_with_counts(fh, options)
+            break if line.nil?
 
-          # replace invalid byte sequence in UTF-8 with question mark to avoid errors
-          line = enforce_utf8_encoding(line, options) if @enforce_utf8
+            # replace invalid byte sequence in UTF-8 with question mark to avoid errors
+            line = enforce_utf8_encoding(line, options) if @enforce_utf8
 
-          $stderr.print "processing file line %10d, csv line %10d\r" % [@file_line_count, @csv_line_count] if @verbose == :debug
+            $stderr.print "processing file line %10d, csv line %10d\r" % [@file_line_count, @csv_line_count] if @verbose == :debug
 
-          next if options[:comment_regexp] && line =~ options[:comment_regexp] # ignore all comment lines if there are any
+            next if options[:comment_regexp] && line =~ options[:comment_regexp] # ignore all comment lines if there are any
+
+            # Snapshot line counters before multiline stitching so error records reflect
+            # where the bad row started, not where it failed.
+            bad_row_start_csv_line  = @csv_line_count
+            bad_row_start_file_line = @file_line_count
+          end
 
-          # Snapshot line counters before multiline stitching so error records reflect
-          # where the bad row started, not where it failed.
-          bad_row_start_csv_line  = @csv_line_count
-          bad_row_start_file_line = @file_line_count
+          break if rows_last && bad_row_start_csv_line > rows_last
 
           begin
             # --- PARSE (inlined — no method-wrapper overhead on the hot path) ---
             # Replaces: process_line_to_hash → parse_line_to_hash → parse_line_to_hash_auto
             # All routing decisions are pre-baked into ivars set up after header processing.
-            if @use_acceleration
-              hash, data_size = parse_line_to_hash_ctx_c(line, @parse_ctx)
+            if block_row
+              # already parsed (and stitched) by the block reader; -1 is an unclosed quote at EOF
+              raise MalformedCSV, "Unclosed quoted field detected in multiline data" if data_size == -1
+            elsif replay_over_limit
+              replay_over_limit = false
+              raise multiline_field_size_error(line)
+            elsif @use_acceleration
+              hash, data_size = parse_line_to_hash_ctx_c(line, @parse_ctx, @parse_cont)
               # :auto only: if unclosed quote AND backslash present, RFC may close it differently
               if @quote_escaping_auto && data_size == -1 && line.include?('\\')
-                hash, data_size = parse_line_to_hash_ctx_c(line, @parse_ctx_double)
+                hash, data_size = parse_line_to_hash_ctx_c(line, @parse_ctx_double, @parse_cont_double)
               end
             else
               has_quotes = line.include?(@quote_char)
@@ -328,21 +409,20 @@ module SmarterCSV
             # --- MULTILINE STITCH ---
             # data_size == -1 means the parser saw an unclosed quoted field at end-of-line.
             # Fetch the next physical line, append, and re-parse until the field closes.
+            # (In block mode data_size is never -1 here: the block reader stitches itself.)
+            # The line grows in place: the C parser's continuation only resumes on the same
+            # String, and it avoids copying the whole row for every appended line.
             while data_size == -1
               next_line = fh.gets(options[:row_sep])
               raise MalformedCSV, "Unclosed quoted field detected in multiline data" if next_line.nil?
 
               next_line = enforce_utf8_encoding(next_line, options) if @enforce_utf8
-              line += next_line
+              line << next_line
               @file_line_count += 1
               $stderr.print "\nline contains unclosed quoted field, including content through file line %d\n" % @file_line_count if @verbose == :debug
 
               # DoS guard: prevent runaway multiline accumulation (vectors: never-closing quote, huge embedded content)
-              if @field_size_limit && line.bytesize > @field_size_limit
-                raise SmarterCSV::FieldSizeLimitExceeded,
-                      "Multiline field exceeds field_size_limit of #{@field_size_limit} bytes " \
-                      "(accumulated #{line.bytesize} bytes)"
-              end
+              raise multiline_field_size_error(line) if @field_size_limit && line.bytesize > @field_size_limit
 
               # Opt #8 (memchr guard): if the newly appended line contains no quote character,
               # it cannot close the currently open quoted field — skip the full re-parse and
@@ -351,9 +431,10 @@ module SmarterCSV
 
               if @use_acceleration
                 # :nocov:
-                hash, data_size = parse_line_to_hash_ctx_c(line, @parse_ctx)
+                # resumes the scan at the end of the previous line (see new_parse_continuation_c)
+                hash, data_size = parse_line_to_hash_ctx_c(line, @parse_ctx, @parse_cont)
                 if @quote_escaping_auto && data_size == -1 && line.include?('\\')
-                  hash, data_size = parse_line_to_hash_ctx_c(line, @parse_ctx_double)
+                  hash, data_size = parse_line_to_hash_ctx_c(line, @parse_ctx_double, @parse_cont_double)
                 end
                 # :nocov:
               else
@@ -372,6 +453,7 @@ module SmarterCSV
             end
 
             # --- EXTRA COLUMNS ---
+            # (the block reader has already grown @headers unless missing_headers is :raise)
             if data_size > @headers.size
               raise SmarterCSV::HeaderSizeMismatch, "extra columns detected on line #{@file_line_count}" if options[:missing_headers] == :raise
 
@@ -380,13 +462,16 @@ module SmarterCSV
               end
             end
 
+            next if rows_first && bad_row_start_csv_line < rows_first
+
             next if hash.nil?
+            next if block_row && direct_columns # the row went straight into the column builder
 
             # --- FIELD SIZE LIMIT CHECK ---
             # Pre-filter: if the raw line fits within the limit, no individual field can exceed it
             # (a field is always a substring of its row). Only iterate over values for large rows.
             if @field_size_limit && line.bytesize > @field_size_limit
-              hash.each_value do |v|
+              (hash.is_a?(Array) ? hash : hash.each_value).each do |v|
                 if v.is_a?(String) && v.bytesize > @field_size_limit
                   raise SmarterCSV::FieldSizeLimitExceeded,
                         "Field exceeds field_size_limit of #{@field_size_limit} bytes (got #{v.bytesize} bytes)"
@@ -394,52 +479,61 @@ module SmarterCSV
               end
             end
 
-            # --- COLUMN SELECTION ---
-            hash.select! { |k, _| @only_headers_set.include?(k) }   if @only_headers_set
-            hash.reject! { |k, _| @except_headers_set.include?(k) } if @except_headers_set
-
-            # --- HASH CLEANUP & TRANSFORMATIONS ---
-            if @use_acceleration
-              # C already applied: remove_empty_values, convert_values_to_numeric, remove_zero_values.
-              # Remove nil/"" keys left by key_mapping or empty CSV headers.
-              if @delete_nil_keys
-                hash.delete(nil)
-                hash.delete('')
-              end
-              hash.delete(:"") if @delete_empty_keys
+            if @rows_as_arrays && @use_acceleration
+              # the C parser built an Array row; what is left of the hash cleanup works by position
+              hash = array_row_transformations(hash, options)
+              next if hash.nil?
+            else
+              # --- COLUMN SELECTION ---
+              hash.select! { |k, _| @only_headers_set.include?(k) }   if @only_headers_set
+              hash.reject! { |k, _| @except_headers_set.include?(k) } if @except_headers_set
 
-              if (matcher = options[:nil_values_matching])
-                if options[:remove_empty_values]
-                  hash.delete_if do |_k, v|
-                    str_val = v.is_a?(String) ? v : (v.is_a?(Numeric) ? v.to_s : nil)
-                    str_val && matcher.match?(str_val)
-                  end
-                else
-                  hash.each_key do |k|
-                    v = hash[k]
-                    str_val = v.is_a?(String) ? v : (v.is_a?(Numeric) ? v.to_s : nil)
-                    hash[k] = nil if str_val && matcher.match?(str_val)
+              # --- HASH CLEANUP & TRANSFORMATIONS ---
+              if @use_acceleration
+                # C already applied: remove_empty_values, convert_values_to_numeric, remove_zero_values.
+                # Remove nil/"" keys left by key_mapping or empty CSV headers.
+                if @delete_nil_keys
+                  hash.delete(nil)
+                  hash.delete('')
+                end
+                hash.delete(:"") if @delete_empty_keys
+
+                if (matcher = options[:nil_values_matching])
+                  if options[:remove_empty_values]
+                    hash.delete_if do |_k, v|
+                      str_val = v.is_a?(String) ? v : (v.is_a?(Numeric) ? v.to_s : nil)
+                      str_val && matcher.match?(str_val)
+                    end
+                  else
+                    hash.each_key do |k|
+                      v = hash[k]
+                      str_val = v.is_a?(String) ? v : (v.is_a?(Numeric) ? v.to_s : nil)
+                      hash[k] = nil if str_val && matcher.match?(str_val)
+                    end
                   end
                 end
-              end
 
-              if options[:value_converters]
-                options[:value_converters].each do |key, converter|
-                  hash[key] = converter.respond_to?(:convert) ? converter.convert(hash[key]) : converter.call(hash[key]) if hash.key?(key)
+                if options[:value_converters]
+                  options[:value_converters].each do |key, converter|
+                    hash[key] = converter.respond_to?(:convert) ? converter.convert(hash[key]) : converter.call(hash[key]) if hash.key?(key)
+                  end
                 end
+              else
+                hash = hash_transformations(hash, options)
               end
-            else
-              hash = hash_transformations(hash, options)
-            end
 
-            next if options[:remove_empty_hashes] && hash.empty?
+              next if options[:remove_empty_hashes] && hash.empty?
+              hash = hash.values_at(*@headers) if @rows_as_arrays # rows_as: :arrays without the C extension
+            end
 
             $stderr.puts "CSV Line #{@file_line_count}: #{pp(hash)}" if @verbose == :debug
             # optional adding of csv_line_number to the hash to help debugging
             hash[:csv_line_number] = @csv_line_count if options[:with_line_numbers]
           rescue SmarterCSV::Error, EOFError => e
+            next if rows_first && bad_row_start_csv_line < rows_first
             raise if options[:on_bad_row] == :raise
 
+            line ||= SmarterCSV::Parser.block_row_line_c(block_reader, (block_idx / 3) - 1) if block_row
             handle_bad_row(e, line, bad_row_start_csv_line, bad_row_start_file_line, options)
             next
           end
@@ -448,8 +542,14 @@ module SmarterCSV
           if use_chunks
             chunk << hash # append temp result to chunk
 
-            if chunk.size >= chunk_size || fh.eof? # if chunk if full, or EOF reached
-              on_chunk&.call({ chunk_number: @chunk_count + 1, rows_in_chunk: chunk.size, total_rows_so_far: @csv_line_count })
+            # in block mode the IO can reach EOF while parsed rows are still pending
+            at_eof = block_reader || replay&.any? ? false : fh.eof?
+            if chunk.size >= chunk_size || at_eof # if chunk if full, or EOF reached
+              if @checkpointable
+                row_end = @block_reader_start + SmarterCSV::Parser.block_reader_offset_c(block_reader, (block_idx / 3) - 1) if block_row
+                @checkpoint = take_checkpoint(row_end || fh.pos)
+              end
+              on_chunk&.call({ chunk_number: @chunk_count + 1, rows_in_chunk: chunk.size, total_rows_so_far: @csv_line_count, checkpoint: @checkpoint })
               # do something with the chunk
               if block_given?
                 yield chunk, @chunk_count # do something with the hashes in the chunk in the block
@@ -467,6 +567,8 @@ module SmarterCSV
             if block_given?
               yield [hash], @chunk_count # do something with the hash in the block (better to use chunking here)
               @chunk_count += 1
+            elsif column_builder
+              SmarterCSV::Parser.column_builder_push_c(column_builder, hash)
             else
               @result << hash
             end
@@ -478,7 +580,10 @@ module SmarterCSV
 
         # handling of last chunk:
         if !chunk.nil? && chunk.size > 0
-          on_chunk&.call({ chunk_number: @chunk_count + 1, rows_in_chunk: chunk.size, total_rows_so_far: @csv_line_count })
+          if @checkpointable
+            @checkpoint = take_checkpoint(block_reader ? @block_reader_start + SmarterCSV::Parser.block_reader_offset_c(block_reader) : fh.pos)
+          end
+          on_chunk&.call({ chunk_number: @chunk_count + 1, rows_in_chunk: chunk.size, total_rows_so_far: @csv_line_count, checkpoint: @checkpoint })
           # do something with the chunk
           if block_given?
             yield chunk, @chunk_count # do something with the hashes in the chunk in the block
@@ -489,6 +594,10 @@ module SmarterCSV
           # chunk = [] # initialize for next chunk of data
         end
 
+        if columnar
+          @result = column_builder ? SmarterCSV::Parser.columns_c(column_builder) : rows_to_columns(@result)
+        end
+
         if on_complete
           on_complete.call({
                              total_rows: @csv_line_count,
@@ -498,16 +607,41 @@ module SmarterCSV
                            })
         end
       ensure
+        # a read_ahead thread reads the IO's fd — stop it before the IO is closed
+        SmarterCSV::Parser.close_block_reader_c(block_reader) if block_reader
         fh.close if fh.respond_to?(:close)
       end
 
       if block_given?
         @chunk_count # when we do processing through a block we only care how many chunks we processed
       else
-        @result # returns either an Array of Hashes, or an Array of Arrays of Hashes (if in chunked mode)
+        @result # returns either an Array of Hashes, an Array of Arrays of Hashes (if in chunked mode), or a Hash of columns
       end
     end
 
+    # Writes the row-offset index of a file input to its sidecar (`<path>.csvidx`, or the
+    # path given as index:) and returns the sidecar path. See SmarterCSV::RowIndex.
+    def build_index
+      path = input_path
+      raise SmarterCSV::IncorrectOption, "build_index needs a file path, not an IO" unless path
+
+      index_path = options[:index].is_a?(String) ? options[:index] : RowIndex.path_for(path)
+      stat = File.stat(path)
+      fh = File.open(path, "r:#{options[:file_encoding]}")
+      raise SmarterCSV::IncorrectOption, "build_index does not support transcoding file_encoding #{options[:file_encoding].inspect}" if fh.internal_encoding
+
+      detect_and_read_headers(fh, true, options)
+      data_start = fh.pos
+      fh.close
+      every = options[:index_every]
+      entries, row_count = row_index_entries(path, data_start, every, options)
+      RowIndex.new(file_size: stat.size, mtime_ns: RowIndex.mtime_ns_of(stat), head_crc: RowIndex.head_crc(path, data_start),
+                   data_start: data_start, every: every, row_count: row_count, key: RowIndex.key_for(options),
+                   entries: entries).write(index_path)
+    ensure
+      fh&.close unless fh&.closed?
+    end
+
     def count_quote_chars(line, quote_char, col_sep = ",", quote_escaping = :double_quotes)
       return 0 if line.nil? || quote_char.nil? || quote_char.empty?
 
@@ -623,6 +757,399 @@ module SmarterCSV
       false
     end
 
+    GZIP_MAGIC = "\x1F\x8B".b.freeze
+
+    # compression: :gzip, or :auto and the input starts with the gzip magic bytes. :auto
+    # only looks at inputs it can put the two bytes back into: paths and seekable IOs.
+    def gzip_input?(fh, options)
+      case options[:compression]
+      when :gzip
+        true
+      when :auto
+        return false unless fh.respond_to?(:pos=) && seekable?(fh)
+
+        start = fh.pos
+        magic = fh.read(2)
+        fh.pos = start
+        magic&.b == GZIP_MAGIC
+      else
+        false
+      end
+    end
+
+    # An IO over the inflated input. With the C extension zlib runs in C: SmarterCSV::GzipIO
+    # answers detection and header reads, and the block reader inflates straight into its
+    # parse buffer. Without it, or when transcoding, Zlib::GzipReader does the work.
+    def gunzip(fh, options)
+      require 'zlib'
+      external = (fh.respond_to?(:external_encoding) && fh.external_encoding) || Encoding.default_external
+      internal = fh.respond_to?(:internal_encoding) && fh.internal_encoding
+      if options[:acceleration] && has_acceleration && !internal && SmarterCSV::Parser.respond_to?(:new_gzip_io_c)
+        if fh.is_a?(File)
+          fh.seek(fh.pos) # drops Ruby's read buffer, so the descriptor stands where fh does
+          SmarterCSV::Parser.new_gzip_io_c(fh, fh.fileno, external)
+        else
+          SmarterCSV::Parser.new_gzip_io_c(fh, nil, external)
+        end
+      else
+        encodings = { external_encoding: external }
+        encodings[:internal_encoding] = internal if internal
+        Zlib::GzipReader.new(fh, **encodings)
+      end
+    end
+
+    # Returns a C block reader for the data rows of `fh`, or nil when the line loop must
+    # be used. The block reader parses with the same ParseContext as the line loop, so
+    # it is only used where reading raw blocks is equivalent to reading lines:
+    #   - the C extension is in use and the input can #read in its external_encoding; a
+    #     transcoding Zlib::GzipReader reports the internal encoding as external_encoding
+    #     (and has no #internal_encoding) while #read returns the untranscoded bytes
+    #   - no per-line Ruby work: comment_regexp and the field_size_limit guard
+    #     operate on the raw line String
+    #   - the input encoding is ASCII-compatible, so the row separator can be found bytewise
+    #   - transcoding (IO#read returns untranscoded bytes) and UTF-8 enforcement only
+    #     where C gives the bytes of the IO / enforce_utf8_encoding: see
+    #     single_byte_transcoding and utf8_repair_in_c?
+    def new_block_reader(fh, options)
+      return nil unless @use_acceleration && fh.respond_to?(:read) && fh.respond_to?(:external_encoding)
+      return nil if defined?(Zlib::GzipReader) && fh.is_a?(Zlib::GzipReader)
+      return nil if options[:comment_regexp] || @field_size_limit
+      return nil unless options[:row_sep].is_a?(String) && !options[:row_sep].empty?
+
+      encoding = fh.external_encoding
+      return nil unless encoding&.ascii_compatible?
+
+      transcoding = single_byte_transcoding(fh, encoding, options)
+      return nil if fh.respond_to?(:internal_encoding) && fh.internal_encoding && !transcoding
+      return nil if @enforce_utf8 && !transcoding && !utf8_repair_in_c?(encoding, options)
+
+      source = encoding
+      encoding = Encoding::UTF_8 if @enforce_utf8 || transcoding
+
+      # a BOM is only stripped from the very first line of the input;
+      # with parallel: N each #read hands N threads a BLOCK_READ_SIZE slice apiece
+      threads = options[:parallel]
+      strip_bom = @csv_line_count == 0
+      @block_reader_start = fh.pos if @checkpointable
+      if options[:io_mode] == :mmap && !@enforce_utf8 && !transcoding && !@input.respond_to?(:gets) && fh.is_a?(File)
+        # io_mode: :mmap parses the file from a mapping, starting where fh stands after the header
+        path = @input.respond_to?(:to_path) ? @input.to_path : @input
+        block_reader = SmarterCSV::Parser.new_mmap_block_reader_c(path, fh.pos, encoding, BLOCK_READ_SIZE * threads, strip_bom, threads)
+        if block_reader
+          @block_reader_start = 0 # a mapping counts from the start of the file
+          return block_reader
+        end
+      end
+      block_reader = SmarterCSV::Parser.new_block_reader_c(fh, encoding, BLOCK_READ_SIZE * threads, strip_bom, threads)
+      if transcoding
+        SmarterCSV::Parser.block_reader_transcode_c(block_reader, source, *transcoding)
+      elsif @enforce_utf8
+        SmarterCSV::Parser.block_reader_enforce_utf8_c(block_reader, options[:invalid_byte_sequence])
+      end
+      start_read_ahead(block_reader, fh, options[:read_ahead], BLOCK_READ_SIZE * threads) if options[:read_ahead]
+      block_reader
+    end
+
+    # force_utf8 on the block reader: the C validator checks the input as UTF-8 and replaces
+    # invalid sequences, which is what enforce_utf8_encoding does for UTF-8 and binary
+    # input (other encodings are transcoded, and stay on the line loop). The replacement
+    # goes into the raw bytes before rows are split, so it must not hold a character that
+    # could change where a row or field ends.
+    def utf8_repair_in_c?(encoding, options)
+      return false unless [Encoding::UTF_8, Encoding::ASCII_8BIT].include?(encoding)
+      return false unless SmarterCSV::Parser.respond_to?(:block_reader_enforce_utf8_c)
+
+      safe_replacement?(options)
+    end
+
+    def safe_replacement?(options)
+      replacement = options[:invalid_byte_sequence].to_s
+      return false unless replacement.ascii_only? || (replacement.encoding == Encoding::UTF_8 && replacement.valid_encoding?)
+
+      structural = [options[:quote_char], options[:col_sep], options[:row_sep], '\\', "\r", "\n"]
+      structural.none? { |s| s.is_a?(String) && s.each_char.any? { |c| replacement.include?(c) } }
+    end
+
+    # A single-byte charset (ISO-8859-x, Windows-125x, ...) read as UTF-8 — through a
+    # transcoding File ('windows-1252:utf-8') or enforce_utf8_encoding ('windows-1252') —
+    # is transcoded by the block reader in C with a table of the 256 bytes, built here from
+    # Ruby's own converter. Returns [table, replacement], or nil for the line loop. The
+    # replacement is nil where the IO would transcode: a byte without a UTF-8 form then
+    # raises Encoding::UndefinedConversionError, as IO#gets does.
+    def single_byte_transcoding(fh, encoding, options)
+      return nil if [Encoding::UTF_8, Encoding::ASCII_8BIT, Encoding::US_ASCII].include?(encoding)
+      return nil unless SmarterCSV::Parser.respond_to?(:block_reader_transcode_c)
+
+      internal = fh.respond_to?(:internal_encoding) && fh.internal_encoding
+      if internal
+        # a File's #read hands out the bytes before transcoding, from where #gets stopped
+        return nil unless internal == Encoding::UTF_8 && fh.is_a?(File)
+
+        replacement = nil
+      elsif @enforce_utf8 && safe_replacement?(options)
+        replacement = options[:invalid_byte_sequence].to_s
+      else
+        return nil
+      end
+      table = single_byte_table(encoding)
+      table && [table, replacement]
+    end
+
+    # 4 bytes per byte of `encoding`: the length of its UTF-8 form (0 when it has none),
+    # then that form. nil unless every byte on its own is a character of the encoding.
+    def single_byte_table(encoding)
+      chars = (0..255).map { |b| b.chr.force_encoding(encoding) }
+      return nil unless chars.all?(&:valid_encoding?)
+
+      chars.map do |char|
+        utf8 = begin
+          char.encode(Encoding::UTF_8)
+        rescue Encoding::UndefinedConversionError
+          ''
+        end
+        return nil if utf8.bytesize > 3
+
+        [utf8.bytesize, *utf8.bytes, 0, 0, 0].first(4).pack('C4')
+      end.join.b
+    rescue Encoding::ConverterNotFoundError
+      nil
+    end
+
+    # State after the row ending at `offset`, once the current chunk is done
+    def take_checkpoint(offset)
+      Checkpoint.new(offset: offset, file_line_count: @file_line_count, csv_line_count: @csv_line_count,
+                     chunk_count: @chunk_count + 1, headers: @headers.dup, raw_header: @raw_header,
+                     row_sep: options[:row_sep], col_sep: options[:col_sep], inferred_types: @inferred_types)
+    end
+
+    # Seek to the checkpoint's row and take over its separators, headers and counters;
+    # returns its chunk count.
+    def resume_from_checkpoint(fh, options)
+      checkpoint = Checkpoint.load(options[:resume_from])
+      raise SmarterCSV::IncorrectOption, "resume_from needs a seekable input (File, StringIO)" unless fh.respond_to?(:seek)
+
+      options[:row_sep] = checkpoint.row_sep
+      options[:col_sep] = checkpoint.col_sep
+      @headers = checkpoint.headers.dup
+      @raw_header = checkpoint.raw_header
+      @inferred_types = checkpoint.inferred_types
+      fh.seek(checkpoint.offset)
+      @file_line_count = checkpoint.file_line_count
+      @csv_line_count = checkpoint.csv_line_count
+      checkpoint.chunk_count
+    end
+
+    # a String or Pathname input; nil for an IO
+    def input_path
+      return nil if @input.respond_to?(:gets)
+
+      @input.respond_to?(:to_path) ? @input.to_path : @input
+    end
+
+    # [offset, lines before] of every index_every-th row from data_start, and the row count.
+    # With the C extension the rows are found by the block reader's span scan; otherwise by
+    # the line loop's multiline detection.
+    def row_index_entries(path, data_start, every, options)
+      File.open(path, 'rb') do |io|
+        io.seek(data_start)
+        if options[:acceleration] && has_acceleration && SmarterCSV::Parser.respond_to?(:row_index_c)
+          opts = options.merge(_keep_cols: false)
+          auto = options[:quote_escaping] == :auto
+          ctx = SmarterCSV::Parser.new_parse_context_c(@headers.dup, auto ? opts.merge(quote_escaping: :backslash) : opts)
+          fallback = SmarterCSV::Parser.new_parse_context_c(@headers.dup, opts.merge(quote_escaping: :double_quotes)) if auto
+          block_reader = SmarterCSV::Parser.new_block_reader_c(io, Encoding::BINARY, BLOCK_READ_SIZE, false)
+          packed, row_count = SmarterCSV::Parser.row_index_c(block_reader, ctx, fallback, every)
+          entries = packed.unpack('Q<*').each_slice(2).map { |offset, lines| [data_start + offset, lines] }
+          [entries, row_count]
+        else
+          entries = []
+          offset = data_start
+          row_count = lines = 0
+          while (line = io.gets(options[:row_sep]))
+            entries << [offset, lines] if (row_count % every).zero?
+            row_count += 1
+            lines += 1
+            offset += line.bytesize
+            while detect_multiline(line, options) && (more = io.gets(options[:row_sep]))
+              line << more
+              lines += 1
+              offset += more.bytesize
+            end
+          end
+          [entries, row_count]
+        end
+      end
+    end
+
+    # rows: → [first, last] csv_line_count of the requested rows (last nil: to the end).
+    # With index:, fh is moved to the indexed row at or before the first one.
+    def rows_window(fh, options)
+      rows = options[:rows]
+      first = rows.begin || 0
+      last = rows.end && (rows.exclude_end? ? rows.end - 1 : rows.end)
+      header_rows = @csv_line_count
+      seek_to_indexed_row(fh, first, options) if options[:index]
+      [header_rows + first + 1, last && header_rows + last + 1]
+    end
+
+    def seek_to_indexed_row(fh, row, options)
+      path = input_path
+      index_path = options[:index].is_a?(String) ? options[:index] : path && RowIndex.path_for(path)
+      usable = path && fh.is_a?(File) && !fh.internal_encoding && File.exist?(index_path.to_s)
+      index = RowIndex.load(index_path) if usable
+      unless index&.current?(path, fh.pos, RowIndex.key_for(options))
+        unless options[:verbose] == :quiet
+          record_warning(type: :index, code: usable ? :stale_index : :no_index) do
+            "row index #{index_path.inspect} #{usable ? 'does not match the file or options' : 'is not available'} — reading from the first row. Rebuild it with SmarterCSV.build_index."
+          end
+        end
+        return
+      end
+
+      offset, rows_before, lines_before = index.seek_point(row)
+      return unless offset
+
+      fh.seek(offset)
+      @csv_line_count += rows_before
+      @file_line_count += lines_before
+    end
+
+    # Auto-detection (row_sep, col_sep), skip_lines and the header — everything before the
+    # first data row.
+    def detect_and_read_headers(fh, has_rewind, options)
+      # Auto-detection. Two orchestrations, same detection functions:
+      #   has_rewind=true  → native fh.rewind between passes; BOM is stripped by
+      #                      next_line_with_counts on the first real line.
+      #   has_rewind=false → PeekableIO buffers the first chunk; peek strips BOM,
+      #                      rewind_buffer replays, freeze_buffer! locks the buffer.
+      if options[:row_sep]&.to_sym == :auto || options[:col_sep]&.to_sym == :auto
+        if has_rewind
+          options[:row_sep] = guess_line_ending(fh, options) if options[:row_sep]&.to_sym == :auto
+          fh.rewind
+          @file_line_count = 0
+          @csv_line_count = 0
+          # skip_lines feeds clean data lines to guess_column_separator. When col_sep is
+          # explicit, it's wasted work — the bytes are consumed and rewound. Guard it.
+          skip_lines(fh, options) if options[:skip_lines] && options[:col_sep]&.to_sym == :auto
+          options[:col_sep] = guess_column_separator(fh, options) if options[:col_sep]&.to_sym == :auto
+          fh.rewind
+          @file_line_count = 0
+          @csv_line_count = 0
+        else
+          fh.peek
+          options[:row_sep] = guess_line_ending(fh, options) if options[:row_sep]&.to_sym == :auto
+          rewind_buffer(fh)
+          skip_lines(fh, options) if options[:skip_lines] && options[:col_sep]&.to_sym == :auto
+          options[:col_sep] = guess_column_separator(fh, options) if options[:col_sep]&.to_sym == :auto
+          fh.freeze_buffer!
+          rewind_buffer(fh)
+        end
+      end
+
+      skip_lines(fh, options) if options[:skip_lines] # skip comments
+
+      # NOTE: we are no longer using header_size
+      @headers, _header_size = process_headers(fh, options)
+    end
+
+    # With the C extension, a non-seekable input is buffered by SmarterCSV::StreamBuffer (the
+    # same peek / rewind_buffer / freeze_buffer! contract as PeekableIO, with one C buffer and
+    # a memchr line search). PeekableIO keeps the transcoding (r:ext:int) and non-ASCII cases.
+    def stream_buffer?(fh, options)
+      return false unless options[:acceleration] && has_acceleration && SmarterCSV::Parser.respond_to?(:new_stream_buffer_c)
+      return false unless fh.respond_to?(:read) && fh.respond_to?(:external_encoding)
+      return false if fh.respond_to?(:internal_encoding) && fh.internal_encoding
+
+      encoding = fh.external_encoding
+      encoding.nil? || encoding.ascii_compatible?
+    end
+
+    # read_ahead: hands the rest of an fd-backed input (File, pipe, socket) to a prefetch
+    # thread of the block reader, which read(2)s the fd while this thread parses. What Ruby
+    # has buffered past the header — in PeekableIO and in the IO itself — goes first.
+    def start_read_ahead(block_reader, fh, read_ahead, block_size)
+      buffered = fh.respond_to?(:drain_buffer) # PeekableIO or StreamBuffer
+      io = buffered ? fh.source : fh
+      return unless io.is_a?(::IO) && !io.closed?
+
+      prefix = buffered ? fh.drain_buffer : ''.b
+      begin
+        # returns the IO's own buffer if it has one, so the fd is all that is left
+        prefix << io.readpartial(block_size).b
+      rescue EOFError
+        # nothing after the header
+      end
+      SmarterCSV::Parser.block_reader_read_ahead_c(block_reader, prefix, io.fileno, read_ahead == true ? 2 : read_ahead)
+    end
+
+    # result_format: :columnar — rows can go straight from the block reader into the column
+    # builder when nothing is left to do to them in Ruby once the C parser is done.
+    def columnar_direct?(options)
+      !(@delete_nil_keys || @delete_empty_keys || @only_headers_set || @except_headers_set ||
+        options[:nil_values_matching] || options[:value_converters] || options[:with_line_numbers] || options[:rows] ||
+        @verbose == :debug)
+    end
+
+    # rows_as: :arrays with the C extension. The parser has stored every value at its column
+    # index and left nil where a column is filtered by the keep bitmap or has no value; this
+    # applies the rest of the per-row cleanup of the hash path by position. Returns nil for a
+    # row the hash path would drop.
+    def array_row_transformations(row, options)
+      array_row_plan(options) if @array_plan_size != @headers.size
+
+      @array_nil_indexes.each { |i| row[i] = nil }
+
+      if (matcher = options[:nil_values_matching])
+        row.map! do |v|
+          str_val = v.is_a?(String) ? v : (v.is_a?(Numeric) ? v.to_s : nil)
+          str_val && matcher.match?(str_val) ? nil : v
+        end
+      end
+
+      # the hash path only converts values it kept: nil is a removed value with remove_empty_values
+      @array_converters.each do |i, converter|
+        v = row[i]
+        next if v.nil? && options[:remove_empty_values]
+
+        row[i] = converter.respond_to?(:convert) ? converter.convert(v) : converter.call(v)
+      end
+
+      return nil if options[:remove_empty_hashes] && options[:remove_empty_values] && row.all?(&:nil?)
+
+      row
+    end
+
+    # Which positions array_row_transformations has to clear (columns the hash path deletes
+    # that the C keep bitmap does not cover: nil/empty headers, and filtered extra columns)
+    # and where the value_converters apply. Rebuilt whenever extra columns grow @headers.
+    def array_row_plan(options)
+      bitmap_size = options[:_keep_bitmap]&.bytesize || 0
+      filtered = lambda do |h|
+        (@only_headers_set && !@only_headers_set.include?(h)) || @except_headers_set&.include?(h)
+      end
+      deleted = ->(h) { h.nil? || h == '' || h == :"" }
+
+      @array_nil_indexes = @headers.each_index.select do |i|
+        deleted.call(@headers[i]) || (i >= bitmap_size && filtered.call(@headers[i]))
+      end
+      @array_converters = (options[:value_converters] || {}).filter_map do |key, converter|
+        i = @headers.index(key)
+        [i, converter] if i && !deleted.call(key) && !filtered.call(key)
+      end
+      @array_plan_size = @headers.size
+    end
+
+    # result_format: :columnar without the C extension: pivot the row hashes into Arrays,
+    # nil where a row has no value for a column. A column per key some row has, in the
+    # order the keys first appear — the C column builder keeps the same rule.
+    def rows_to_columns(rows)
+      columns = {}
+      rows.each_with_index do |hash, i|
+        hash.each { |key, value| (columns[key] ||= [])[i] = value }
+      end
+      columns.each_value { |column| column.fill(nil, column.size...rows.size) }
+    end
+
     # Determine if a line has unbalanced quotes requiring multiline stitching.
     # For :auto mode, uses dual counting to avoid false multiline detection.
     # For :standard quote_boundary mode, uses a full state machine so that
@@ -885,6 +1412,12 @@ module SmarterCSV
       hash
     end
 
+    def multiline_field_size_error(line)
+      SmarterCSV::FieldSizeLimitExceeded.new(
+        "Multiline field exceeds field_size_limit of #{@field_size_limit} bytes (accumulated #{line.bytesize} bytes)"
+      )
+    end
+
     def enforce_utf8_encoding(line, options)
       replace = options[:invalid_byte_sequence]
       # ASCII_8BIT (Encoding::BINARY is an alias) has no codepoint mapping above 0x7F,
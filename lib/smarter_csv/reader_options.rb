@@ -16,8 +16,10 @@ module SmarterCSV
         col_sep: :auto, # was: ',',
         collect_raw_lines: true,
         comment_regexp: nil, # was: /\A#/,
+        compression: :auto, # :auto (gzip when the input starts with its magic bytes), :gzip, or :none
         convert_values_to_numeric: true,
-        decimal_precision: :auto, # :auto (Float, but BigDecimal above 16 significant digits), :float, or :bigdecimal
+        date_columns: nil, # header keys whose ISO-8601 dates (YYYY-MM-DD) become Date objects
+        decimal_precision: :auto, # :auto (Float, but BigDecimal above 16 significant digits), :float, :bigdecimal, or :rational
         downcase_header: true,
         duplicate_header_suffix: '', # was: nil,
         field_size_limit: nil, # Integer (bytes) or nil for no limit. Raises FieldSizeLimitExceeded if any
@@ -26,7 +28,12 @@ module SmarterCSV
         file_encoding: 'utf-8',
         force_utf8: false,
         headers_in_file: true,
+        index: false, # true (the <path>.csvidx sidecar written by SmarterCSV.build_index) or a sidecar path: rows: seeks with it
+        index_every: SmarterCSV::RowIndex::DEFAULT_EVERY, # rows between the entries SmarterCSV.build_index writes
+        infer_types: false, # true (sample 1000 rows) or an Integer sample size: convert each column by its inferred type
+        intern_columns: nil, # header key(s), or true for all: their String values are frozen and deduplicated
         invalid_byte_sequence: '',
+        io_mode: :read, # :read, or :mmap (a file path is parsed from a read-only mapping; C extension)
         keep_original_headers: false,
         key_mapping: nil,
         strict: false,              # DEPRECATED -> use missing_headers
@@ -37,9 +44,11 @@ module SmarterCSV
         on_chunk: nil,    # callable: fired after each chunk is parsed, before yielding to the block
         on_complete: nil, # callable: fired once after the entire file is processed
         on_start: nil,    # callable: fired once before the first row is parsed
+        parallel: 1,      # Integer: threads parsing each block of the input (C extension; 1 = no threads)
         quote_boundary: :standard, # :standard (only at field boundary 👍) or :legacy (any quote toggles state 👎)
         quote_char: '"',
         quote_escaping: :auto,
+        read_ahead: false, # true (2 blocks) or Integer: blocks of an fd-backed IO read ahead on a native thread
         remove_empty_hashes: true,
         remove_empty_values: true,
         remove_unmapped_keys: false,
@@ -47,12 +56,17 @@ module SmarterCSV
         remove_zero_values: false,
         required_headers: nil,
         required_keys: nil,
+        resume_from: nil, # a checkpoint (reader.checkpoint, or its #dump String): continue reading after it
+        result_format: :rows, # :rows (Array of Hashes) or :columnar ({ header => column }, see docs/options.md)
         row_sep: :auto, # was: $/,
+        rows: nil, # Range of data rows to return (0-based, after the header), e.g. 5_000..5_999
+        rows_as: :hashes, # :hashes, or :arrays (values Arrays aligned to reader.headers)
         silence_missing_keys: false,
         skip_lines: nil,
         strings_as_keys: false,
         strip_chars_from_headers: nil,
         strip_whitespace: true,
+        time_columns: nil, # header keys whose ISO-8601 dates and times become Time objects
         user_provided_headers: nil,
         value_converters: nil,
         verbose: :normal, # nil/:normal (default), :quiet (suppress warnings), :debug (print diagnostics); true/false are deprecated
@@ -63,7 +77,7 @@ module SmarterCSV
       # (e.g. "backslash" from options round-tripped through JSON or YAML) is coerced to
       # the matching symbol. Non-string values (a callable for on_bad_row, true/false for
       # legacy verbose) pass through untouched.
-      SYMBOL_VALUE_OPTIONS = %i[quote_escaping quote_boundary missing_headers on_bad_row verbose decimal_precision].freeze
+      SYMBOL_VALUE_OPTIONS = %i[quote_escaping quote_boundary missing_headers on_bad_row verbose decimal_precision result_format rows_as io_mode compression].freeze
 
       # NOTE: this is not called when "parse" methods are tested by themselves
       def process_options(given_options = {})
@@ -205,8 +219,8 @@ module SmarterCSV
         unless %i[legacy standard].include?(options[:quote_boundary])
           errors << "invalid quote_boundary: must be :legacy or :standard"
         end
-        unless %i[auto float bigdecimal].include?(options[:decimal_precision])
-          errors << "invalid decimal_precision: must be :auto, :float, or :bigdecimal"
+        unless %i[auto float bigdecimal rational].include?(options[:decimal_precision])
+          errors << "invalid decimal_precision: must be :auto, :float, :bigdecimal, or :rational"
         end
         arc = options[:auto_row_sep_chars]
         min_arc = SmarterCSV::AutoDetection::MIN_AUTO_ROW_SEP_CHARS
@@ -265,6 +279,66 @@ module SmarterCSV
         unless fsl.nil? || (fsl.is_a?(Integer) && fsl > 0)
           errors << "invalid field_size_limit: must be nil or a positive Integer (got #{fsl.inspect})"
         end
+        unless %i[rows columnar].include?(options[:result_format])
+          errors << "invalid result_format: must be :rows or :columnar"
+        end
+        if options[:result_format] == :columnar && options[:chunk_size].to_i > 0
+          errors << "result_format: :columnar cannot be combined with chunk_size"
+        end
+        it = options[:infer_types]
+        unless [true, false].include?(it) || (it.is_a?(Integer) && it > 0)
+          errors << "invalid infer_types: must be true, false, or a positive Integer (got #{it.inspect})"
+        end
+        %i[date_columns time_columns].each do |opt|
+          keys = options[opt]
+          next if keys.nil? || Array(keys).all? { |key| key.is_a?(Symbol) || key.is_a?(String) }
+
+          errors << "invalid #{opt}: must be a header key or an Array of header keys (got #{keys.inspect})"
+        end
+        ic = options[:intern_columns]
+        unless ic.nil? || ic == true || Array(ic).all? { |key| key.is_a?(Symbol) || key.is_a?(String) }
+          errors << "invalid intern_columns: must be true, a header key or an Array of header keys (got #{ic.inspect})"
+        end
+        if options[:value_converters].is_a?(Hash)
+          unknown = options[:value_converters].values.grep(Symbol) - SmarterCSV::TypeInference::COLUMN_TYPES
+          errors << "invalid value_converters: unknown converter #{unknown.map(&:inspect).join(', ')}" unless unknown.empty?
+        end
+        both = Array(options[:date_columns]) & Array(options[:time_columns])
+        errors << "columns in both date_columns and time_columns: #{both.inspect}" unless both.empty?
+        unless %i[hashes arrays].include?(options[:rows_as])
+          errors << "invalid rows_as: must be :hashes or :arrays"
+        end
+        if options[:rows_as] == :arrays
+          errors << "rows_as: :arrays cannot be combined with result_format: :columnar" if options[:result_format] == :columnar
+          errors << "rows_as: :arrays cannot be combined with with_line_numbers" if options[:with_line_numbers]
+        end
+        unless %i[auto gzip none].include?(options[:compression])
+          errors << "invalid compression: must be :auto, :gzip, or :none"
+        end
+        unless %i[read mmap].include?(options[:io_mode])
+          errors << "invalid io_mode: must be :read or :mmap"
+        end
+        rf = options[:resume_from]
+        unless rf.nil? || rf.is_a?(String) || rf.is_a?(SmarterCSV::Checkpoint)
+          errors << "invalid resume_from: must be a SmarterCSV::Checkpoint or its #dump String"
+        end
+        rows = options[:rows]
+        unless rows.nil? || (rows.is_a?(Range) && [rows.begin, rows.end].all? { |n| n.nil? || (n.is_a?(Integer) && n >= 0) })
+          errors << "invalid rows: must be a Range of row numbers >= 0 (got #{rows.inspect})"
+        end
+        unless [true, false].include?(options[:index]) || options[:index].is_a?(String)
+          errors << "invalid index: must be true, false, or the path of a row index"
+        end
+        ie = options[:index_every]
+        errors << "invalid index_every: must be a positive Integer (got #{ie.inspect})" unless ie.is_a?(Integer) && ie > 0
+        ra = options[:read_ahead]
+        unless ra == true || ra == false || (ra.is_a?(Integer) && ra > 0)
+          errors << "invalid read_ahead: must be true, false, or a positive Integer (got #{ra.inspect})"
+        end
+        par = options[:parallel]
+        unless par.is_a?(Integer) && par > 0 && par <= PARALLEL_MAX_THREADS
+          errors << "invalid parallel: must be an Integer from 1 to #{PARALLEL_MAX_THREADS} (got #{par.inspect})"
+        end
         obr = options[:on_bad_row]
         unless %i[raise skip collect].include?(obr) || obr.respond_to?(:call)
           errors << "invalid on_bad_row: must be :raise, :skip, :collect, or a callable"
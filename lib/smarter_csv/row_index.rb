@@ -0,0 +1,97 @@
+# frozen_string_literal: true
+
+module SmarterCSV
+  # A row-offset index of a CSV file, kept in a sidecar file next to it (`data.csv.csvidx`).
+  #
+  # SmarterCSV.build_index writes it; Reader.new(path, index: true, rows: 5_000..6_000) reads
+  # it to seek close to the first requested row instead of parsing from byte 0.
+  #
+  # It holds, for every Nth data row (`every`), the row's byte offset and the number of
+  # physical lines before it, counted from the first data row. Rows are logical CSV rows
+  # after the header — the rows `csv_line_count` counts, blank ones included; a multiline
+  # row is one row.
+  #
+  # Sidecar layout (little-endian): magic, file size, file mtime (ns), CRC32 of the bytes
+  # before the first data row, the offset of that row, every, row count, the options that
+  # decide where rows end (row_sep, col_sep, quoting), then (offset, lines) pairs.
+  class RowIndex
+    MAGIC = "SCSVIDX\x01".b.freeze
+    HEAD_FORMAT = 'a8Q<q<L<Q<Q<Q<L<'
+    HEAD_SIZE = 56
+    DEFAULT_EVERY = 10_000
+    EXTENSION = '.csvidx'
+
+    attr_reader :file_size, :mtime_ns, :head_crc, :data_start, :every, :row_count, :key, :entries
+
+    def self.path_for(csv_path)
+      "#{csv_path}#{EXTENSION}"
+    end
+
+    # The options a row boundary depends on — an index is only valid for the same ones.
+    def self.key_for(options)
+      options.values_at(:row_sep, :col_sep, :quote_char, :quote_escaping, :quote_boundary, :strip_whitespace).inspect
+    end
+
+    # Fingerprint of the bytes before the first data row (BOM, skipped lines, header).
+    def self.head_crc(csv_path, data_start)
+      require 'zlib'
+      Zlib.crc32(File.binread(csv_path, data_start) || ''.b)
+    end
+
+    def self.load(index_path)
+      data = File.binread(index_path)
+      raise SmarterCSV::Error, "not a SmarterCSV row index: #{index_path}" unless data.bytesize >= HEAD_SIZE && data.start_with?(MAGIC)
+
+      _magic, file_size, mtime_ns, head_crc, data_start, every, row_count, key_size = data.unpack(HEAD_FORMAT)
+      key = data.byteslice(HEAD_SIZE, key_size)
+      entries = data.byteslice(HEAD_SIZE + key_size..).unpack('Q<*').each_slice(2).to_a
+      new(file_size: file_size, mtime_ns: mtime_ns, head_crc: head_crc, data_start: data_start,
+          every: every, row_count: row_count, key: key.force_encoding(Encoding::UTF_8), entries: entries)
+    end
+
+    def initialize(file_size:, mtime_ns:, head_crc:, data_start:, every:, row_count:, key:, entries:)
+      @file_size = file_size
+      @mtime_ns = mtime_ns
+      @head_crc = head_crc
+      @data_start = data_start
+      @every = every
+      @row_count = row_count
+      @key = key
+      @entries = entries # [[offset, lines_before], ...] for rows 0, every, 2 * every, ...
+    end
+
+    def write(index_path)
+      key = @key.b
+      head = [MAGIC, @file_size, @mtime_ns, @head_crc, @data_start, @every, @row_count, key.bytesize].pack(HEAD_FORMAT)
+      File.binwrite(index_path, head + key + @entries.flatten.pack('Q<*'))
+      index_path
+    end
+
+    # True when the index still describes csv_path as the Reader sees it: same size and mtime,
+    # same bytes before the data, same first data row and row-boundary options.
+    def current?(csv_path, data_start, key)
+      stat = File.stat(csv_path)
+      stat.size == @file_size && mtime_ns_of(stat) == @mtime_ns && data_start == @data_start && key == @key &&
+        self.class.head_crc(csv_path, data_start) == @head_crc
+    end
+
+    # [offset, rows_before, lines_before] of the indexed row at or before `row`
+    def seek_point(row)
+      return nil if @entries.empty?
+
+      slot = [row / @every, @entries.size - 1].min
+      offset, lines = @entries[slot]
+      [offset, slot * @every, lines]
+    end
+
+    def self.mtime_ns_of(stat)
+      (stat.mtime.to_r * 1_000_000_000).to_i
+    end
+
+    private
+
+    def mtime_ns_of(stat)
+      self.class.mtime_ns_of(stat)
+    end
+  end
+end
@@ -0,0 +1,189 @@
+# frozen_string_literal: true
+
+module SmarterCSV
+  # Column types: infer_types reads the first rows after the headers and classifies each
+  # column by the values it holds; date_columns, time_columns and Symbol value_converters
+  # (value_converters: { price: :money }) declare them. The types go to the parse context
+  # as _column_types, and the C parser converts each column by its type (a String column
+  # never enters the numeric scan, dates and times are parsed from the field bytes); the
+  # Ruby path does the same in hash_transformations.
+  #
+  # The sampled rows are not lost: their raw lines are replayed through the main loop, so
+  # they are parsed with the same column types as every other row.
+  module TypeInference
+    # Rows sampled with infer_types: true (an Integer chooses another sample size)
+    INFER_TYPES_SAMPLE_ROWS = 1000
+
+    # what value_converters: { key => Symbol } can name
+    COLUMN_TYPES = %i[string integer float decimal boolean date time money integer_with_delimiters percentage].freeze
+
+    BOOLEAN_REGEX  = /\A(?:true|false)\z/i.freeze # what infer_types takes for a boolean
+    BOOLEAN_VALUE_REGEX = /\A(?:(true|t|yes|y|1)|false|f|no|n|0)\z/i.freeze # what a boolean column converts
+    ISO_DATE_REGEX = /\A(\d{4})-(\d{2})-(\d{2})\z/.freeze
+    # the forms of clean_number in the C extension: digits may have thousands separators
+    GROUPED_DIGITS = /\d{1,3}(?:,\d{3})+|\d+/.freeze
+    MONEY_REGEX = /\A(?<open>\()?(?<sign>[+-])?(?:(?<pre>[$€£¥]) ?)?(?<int>#{GROUPED_DIGITS})(?<frac>\.\d+)?(?: ?(?<post>[$€£¥]))?(?<close>\))?\z/.freeze
+    INTEGER_DELIMITED_REGEX = /\A(?<sign>[+-])?(?<int>#{GROUPED_DIGITS})\z/.freeze
+    PERCENT_REGEX = /\A(?<sign>[+-])?(?<int>#{GROUPED_DIGITS})(?<frac>\.\d+)? ?%\z/.freeze
+    # the strict time_columns form (see iso_time_parts in the C extension)
+    ISO_TIME_REGEX = /\A(\d{4})-(\d{2})-(\d{2})[T ](\d{2}):(\d{2}):(\d{2})(?:\.(\d{1,9}))?(Z|[+-]\d{2}(?::?\d{2})?)?\z/.freeze
+
+    # { header => :integer, :float, :decimal, :boolean, :date or :string }; nil for a column
+    # without values in the sample (it keeps the convert_values_to_numeric rules)
+    attr_reader :inferred_types
+
+    private
+
+    # Reads up to N logical rows from fh, sets @inferred_types and returns the rows to replay
+    # as [line, physical_lines, row_end] triples: row_end is fh.pos after the row when
+    # checkpoints are taken, else nil.
+    def infer_column_types(fh, options)
+      limit = options[:infer_types] == true ? INFER_TYPES_SAMPLE_ROWS : options[:infer_types]
+      sample = []
+      kinds = Hash.new { |h, k| h[k] = [] }
+
+      while sample.size < limit && (line = next_line_with_counts(fh, options))
+        lines = 1
+        line = enforce_utf8_encoding(line, options) if @enforce_utf8
+        unless options[:comment_regexp] && line =~ options[:comment_regexp]
+          hash = nil
+          begin
+            loop do
+              hash, data_size = parse_line_to_hash(line, @headers, options)
+              break unless data_size == -1
+
+              next_line = fh.gets(options[:row_sep])
+              break if next_line.nil?
+
+              line += @enforce_utf8 ? enforce_utf8_encoding(next_line, options) : next_line
+              lines += 1
+              # where the line loop's stitch raises FieldSizeLimitExceeded; the replay raises it
+              break if options[:field_size_limit] && line.bytesize > options[:field_size_limit]
+            end
+            hash = hash_transformations(hash, options) if hash && !@use_acceleration
+          rescue SmarterCSV::Error
+            hash = nil # the replay reports it
+          end
+          hash&.each { |key, value| (kinds[key] << inferred_kind(value)) unless value.nil? || value == '' }
+        end
+        sample << [line, lines, (fh.pos if @checkpointable)] # the row's end, for a checkpoint
+      end
+
+      @inferred_types = @headers.to_h { |header| [header, column_type(kinds[header].uniq)] }
+      sample
+    end
+
+    # Symbol value_converters name column types, not callables: they leave
+    # options[:value_converters] before any row is converted (the infer_types sample
+    # included), so the per-row converter loops only see callables. Returns them as
+    # { key => type }.
+    def take_typed_converters(options)
+      converters = options[:value_converters]
+      return {} unless converters&.any? { |_key, converter| converter.is_a?(Symbol) }
+
+      typed, callables = converters.partition { |_key, converter| converter.is_a?(Symbol) }.map(&:to_h)
+      [options, @quote_escaping_backslash, @quote_escaping_double].compact.each do |opts|
+        opts[:value_converters] = callables.empty? ? nil : callables
+      end
+      typed
+    end
+
+    # options[:_column_types]: the inferred types, overridden by date_columns / time_columns
+    # and the Symbol value_converters (typed, from take_typed_converters).
+    def store_column_types(options, typed)
+      column_types = (@inferred_types || {}).compact
+      Array(options[:date_columns]).each { |key| column_types[key] = :date }
+      Array(options[:time_columns]).each { |key| column_types[key] = :time }
+      column_types.merge!(typed)
+      return if column_types.empty?
+
+      [options, @quote_escaping_backslash, @quote_escaping_double].compact.each do |opts|
+        opts[:_column_types] = column_types
+      end
+    end
+
+    def inferred_kind(value)
+      case value
+      when Integer    then :integer
+      when Float      then :float
+      when BigDecimal then :decimal
+      when BOOLEAN_REGEX then :boolean
+      else
+        (m = ISO_DATE_REGEX.match(value)) && Date.valid_date?(m[1].to_i, m[2].to_i, m[3].to_i) ? :date : :string
+      end
+    end
+
+    # one type for all kinds seen in a column: numbers widen to the type that holds them all
+    def column_type(kinds)
+      return nil if kinds.empty?
+      return kinds.first if kinds.size == 1
+      return :string unless (kinds - %i[integer float decimal]).empty?
+
+      kinds.include?(:decimal) ? :decimal : :float
+    end
+
+    # the Ruby path's conversion of a String value in a typed column (see classify_field)
+    def convert_to_column_type(value, type, options)
+      case type
+      when :string
+        value
+      when :boolean
+        (m = BOOLEAN_VALUE_REGEX.match(value)) ? !m[1].nil? : value
+      when :date
+        (m = ISO_DATE_REGEX.match(value)) && Date.valid_date?(m[1].to_i, m[2].to_i, m[3].to_i) ? Date.new(m[1].to_i, m[2].to_i, m[3].to_i) : value
+      when :time
+        iso_time(value) || value
+      when :money, :integer_with_delimiters, :percentage
+        clean_number_value(value, type)
+      else
+        return value unless HashTransformations::NUMERIC_REGEX.match?(value)
+
+        case type
+        when :float   then value.to_f
+        when :decimal then BigDecimal(value)
+        else value.include?('.') || value.match?(/[eE]/) ? convert_decimal(value, options[:decimal_precision]) : value.to_i
+        end
+      end
+    end
+
+    # the value of a :money (BigDecimal), :integer_with_delimiters or :percentage (Float) field,
+    # or the String when it is not in that form
+    def clean_number_value(value, type)
+      m = { money: MONEY_REGEX, integer_with_delimiters: INTEGER_DELIMITED_REGEX, percentage: PERCENT_REGEX }[type].match(value)
+      return value unless m
+
+      negative = m[:sign] == '-'
+      if type == :money
+        return value if m[:open].nil? != m[:close].nil? || (m[:open] && m[:sign]) || (m[:pre] && m[:post])
+
+        negative ||= !m[:open].nil?
+      end
+      number = "#{'-' if negative}#{m[:int].delete(',')}#{m[:frac] if type != :integer_with_delimiters}"
+      case type
+      when :money      then BigDecimal(number)
+      when :percentage then Float(number) / 100
+      else number.to_i
+      end
+    end
+
+    # the Time of a strict ISO-8601 date and time, or nil; no zone is local time, as in Time.iso8601
+    def iso_time(value)
+      m = ISO_TIME_REGEX.match(value)
+      return nil unless m && Date.valid_date?(m[1].to_i, m[2].to_i, m[3].to_i)
+
+      year, month, day, hour, min, sec = (1..6).map { |i| m[i].to_i }
+      return nil if hour > 23 || min > 59 || sec > 59
+
+      sec = Rational((sec * 1_000_000_000) + m[7].ljust(9, '0').to_i, 1_000_000_000) if m[7]
+      case (zone = m[8])
+      when nil then Time.new(year, month, day, hour, min, sec)
+      when 'Z' then Time.utc(year, month, day, hour, min, sec)
+      else
+        offset_min = zone.size == 3 ? '00' : zone[-2, 2]
+        return nil if zone[1, 2].to_i > 23 || offset_min.to_i > 59
+
+        Time.new(year, month, day, hour, min, sec, "#{zone[0, 3]}:#{offset_min}")
+      end
+    end
+  end
+end
@@ -44,6 +44,15 @@ describe 'numeric conversion of values' do
           expect(hash[:reference]).to be_a_kind_of(String) unless hash[:reference].nil?
         end
       end
+
+      it 'applies only:/except: to extra columns that appear later' do
+        csv = "a,b\n1,2\n3,4,5\n6,7,8,9\n"
+        expected = [{ a: '1', b: 2 }, { a: '3', b: 4, column_3: 5 }, { a: '6', b: 7, column_3: 8, column_4: '9' }]
+        [{ only: %i[b column_3] }, { except: %i[a column_4] }].each do |limit|
+          data = SmarterCSV.process(StringIO.new(csv), acceleration: acceleration, convert_values_to_numeric: limit)
+          expect(data).to eq expected
+        end
+      end
     end
 
     # Characterization of numeric-conversion behavior on edge inputs.
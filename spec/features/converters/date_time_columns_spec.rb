@@ -0,0 +1,71 @@
+# frozen_string_literal: true
+
+describe 'date_columns and time_columns' do
+  let(:csv) do
+    "id,day,at,note\n" \
+    "1,2024-02-29,2024-01-31T12:34:56Z,a\n" \
+    "2,2023-02-29,2024-01-31 12:34:56.123+05:30,b\n" \
+    "3,31.01.2024,2024-01-31T12:34:56.5-0800,c\n" \
+    "4,,2024-01-31T24:00:00Z,d\n" \
+    "5,2024-12-01,2024-01-31T23:00:00+02,e\n" \
+    "6,2024-12-01,2024-01-31T23:00:00.1234567891Z,f\n" \
+    "7,2024-12-01,2024-07-01 08:15:00,g\n"
+  end
+
+  def zones(rows)
+    rows.map { |row| row[:at].is_a?(Time) ? [row[:at].utc_offset, row[:at].utc?] : nil }
+  end
+
+  [true, false].each do |acceleration|
+    context "with acceleration: #{acceleration}" do
+      let(:rows) { SmarterCSV.process(StringIO.new(csv), acceleration: acceleration, date_columns: :day, time_columns: [:at]) }
+
+      it 'turns ISO-8601 dates into Date' do
+        expect(rows.map { |row| row[:day] }).to eq [Date.new(2024, 2, 29), '2023-02-29', '31.01.2024', nil] + [Date.new(2024, 12, 1)] * 3
+      end
+
+      it 'turns ISO-8601 times into Time, with their zone' do
+        expect(rows[0][:at]).to eq Time.utc(2024, 1, 31, 12, 34, 56)
+        expect(rows[1][:at]).to eq Time.new(2024, 1, 31, 12, 34, Rational(56_123, 1000), '+05:30')
+        expect(rows[2][:at]).to eq Time.new(2024, 1, 31, 12, 34, 56.5, '-08:00')
+        expect(rows[4][:at]).to eq Time.new(2024, 1, 31, 23, 0, 0, '+02:00')
+        expect(rows[6][:at]).to eq Time.new(2024, 7, 1, 8, 15, 0)
+        expect(zones(rows).values_at(0, 1, 6)).to eq [[0, true], [19_800, false], [Time.new(2024, 7, 1).utc_offset, false]]
+      end
+
+      it 'keeps a value that does not match as a String' do
+        expect(rows[3][:at]).to eq '2024-01-31T24:00:00Z'
+        expect(rows[5][:at]).to eq '2024-01-31T23:00:00.1234567891Z'
+        expect(rows[0][:note]).to eq 'a'
+      end
+
+      it 'converts an extra column from its first row on' do
+        data = SmarterCSV.process(StringIO.new("a\n1,2024-01-31T00:00:00Z\n2,2024-02-01T00:00:00Z\n"),
+                                  acceleration: acceleration, time_columns: :column_2)
+        expect(data.map { |row| row[:column_2] }).to eq [Time.utc(2024, 1, 31), Time.utc(2024, 2, 1)]
+      end
+    end
+  end
+
+  it 'gives the same values as the Ruby path, also with parallel, rows_as and result_format' do
+    options = { date_columns: :day, time_columns: :at }
+    rows = SmarterCSV.process(StringIO.new(csv), options.merge(acceleration: false))
+    expect(SmarterCSV.process(StringIO.new(csv), options.merge(parallel: 2))).to eq rows
+    expect(zones(SmarterCSV.process(StringIO.new(csv), options))).to eq zones(rows)
+    arrays = SmarterCSV.process(StringIO.new(csv), options.merge(rows_as: :arrays))
+    expect(arrays.map { |row| row[2] }).to eq(rows.map { |row| row[:at] })
+    columns = SmarterCSV.process(StringIO.new(csv), options.merge(result_format: :columnar))
+    expect(columns[:day]).to eq(rows.map { |row| row[:day] })
+  end
+
+  it 'overrides the type inferred by infer_types' do
+    reader = SmarterCSV::Reader.new(StringIO.new(csv), infer_types: true, time_columns: :at)
+    expect(reader.process.first[:at]).to eq Time.utc(2024, 1, 31, 12, 34, 56)
+  end
+
+  it 'rejects invalid column lists' do
+    expect { SmarterCSV.process(StringIO.new(csv), date_columns: [1]) }.to raise_error(SmarterCSV::ValidationError, /date_columns/)
+    expect { SmarterCSV.process(StringIO.new(csv), date_columns: :at, time_columns: :at) }
+      .to raise_error(SmarterCSV::ValidationError, /both date_columns and time_columns/)
+  end
+end
@@ -0,0 +1,61 @@
+# frozen_string_literal: true
+
+describe 'value_converters with a Symbol' do
+  let(:csv) do
+    "price,qty,rate,active,note\n" \
+    "\"$1,234.50\",\"12,345,678\",12.5%,Yes,a\n" \
+    "(12.00),-1234,-3 %,0,b\n" \
+    "9 €,+7,100,false,c\n" \
+    "\"1,23\",\"1,2345\",%,maybe,d\n" \
+    "($5),99999999999999999999,\"1,000.5%\",T,e\n"
+  end
+  let(:converters) do
+    { price: :money, qty: :integer_with_delimiters, rate: :percentage, active: :boolean, note: ->(v) { v.upcase } }
+  end
+
+  [true, false].each do |acceleration|
+    context "with acceleration: #{acceleration}" do
+      let(:rows) { SmarterCSV.process(StringIO.new(csv), acceleration: acceleration, value_converters: converters) }
+
+      it 'converts :money to BigDecimal' do
+        expect(rows.map { |row| row[:price] }).to eq [BigDecimal('1234.5'), BigDecimal('-12'), BigDecimal('9'), '1,23', BigDecimal('-5')]
+        expect(rows[0][:price]).to be_a BigDecimal
+      end
+
+      it 'converts :integer_with_delimiters to Integer' do
+        expect(rows.map { |row| row[:qty] }).to eq [12_345_678, -1234, 7, '1,2345', 99_999_999_999_999_999_999]
+      end
+
+      it 'converts :percentage to a Float fraction' do
+        expect(rows.map { |row| row[:rate] }).to eq [0.125, -0.03, '100', '%', 10.005]
+      end
+
+      it 'converts :boolean' do
+        expect(rows.map { |row| row[:active] }).to eq [true, false, false, 'maybe', true]
+      end
+
+      it 'still calls the other converters' do
+        expect(rows.map { |row| row[:note] }).to eq %w[A B C D E]
+      end
+    end
+  end
+
+  it 'gives the same values with parallel, rows_as and result_format' do
+    rows = SmarterCSV.process(StringIO.new(csv), value_converters: converters)
+    expect(SmarterCSV.process(StringIO.new(csv), value_converters: converters, parallel: 2)).to eq rows
+    arrays = SmarterCSV.process(StringIO.new(csv), value_converters: converters, rows_as: :arrays)
+    expect(arrays).to eq(rows.map(&:values))
+    columns = SmarterCSV.process(StringIO.new(csv), value_converters: converters, result_format: :columnar)
+    expect(columns[:price]).to eq(rows.map { |row| row[:price] })
+  end
+
+  it 'accepts the column types of infer_types' do
+    data = SmarterCSV.process(StringIO.new("a,b\n007,2024-01-31\n"), value_converters: { a: :string, b: :date })
+    expect(data).to eq [{ a: '007', b: Date.new(2024, 1, 31) }]
+  end
+
+  it 'rejects an unknown converter name' do
+    expect { SmarterCSV.process(StringIO.new(csv), value_converters: { price: :dollars }) }
+      .to raise_error(SmarterCSV::ValidationError, /unknown converter :dollars/)
+  end
+end
@@ -0,0 +1,80 @@
+# frozen_string_literal: true
+
+# Coverage for the structural indexer (SECTION 5a of parse_row_ctx): in RFC quoting mode
+# the C parser classifies each row 64 bytes at a time into quote/separator bitmasks and
+# jumps from field boundary to field boundary. Fields whose shape the quote toggling
+# cannot vouch for fall back to the byte-by-byte state machine for the whole row.
+#
+# Bugs here would show up when a quote or separator sits right at a 64-byte block edge,
+# when a quoted region spans blocks, or in the lenient cases the fallback owns — so every
+# case runs on both the C and Ruby paths and must produce identical output.
+
+BLOCK_EDGE_OFFSETS = [61, 62, 63, 64, 65, 66, 127, 128, 129].freeze
+
+[true, false].each do |acceleration|
+  describe "structural indexer with#{acceleration ? ' C-' : 'out '}acceleration" do
+    def parse(csv, acceleration, **options)
+      SmarterCSV.process(StringIO.new(csv), acceleration: acceleration, quote_escaping: :double_quotes, **options)
+    end
+
+    context 'field boundaries at 64-byte block edges' do
+      BLOCK_EDGE_OFFSETS.each do |offset|
+        it "splits on a separator at offset #{offset}" do
+          first = 'a' * (offset - 1)
+          data = parse("a,b,c\n\"#{first}\",x,\"y,z\"\n", acceleration)
+          expect(data).to eq [{ a: first, b: 'x', c: 'y,z' }]
+        end
+
+        it "keeps separators inside a quoted region spanning offset #{offset}" do
+          content = ('p,' * offset)[0, offset] + '"",' + ('q,' * 40)
+          data = parse("a,b\n\"#{content}\",Z\n", acceleration)
+          expect(data).to eq [{ a: content.sub('""', '"'), b: 'Z' }]
+        end
+      end
+    end
+
+    it 'handles embedded row separators and doubled quotes' do
+      data = parse("a,b,c\n\"line 1\nline 2\",\"say \"\"hi\"\"\",\"\"\n", acceleration, remove_empty_values: false)
+      expect(data).to eq [{ a: "line 1\nline 2", b: 'say "hi"', c: '' }]
+    end
+
+    context 'quote_boundary: :standard (rows the state machine has to finish)' do
+      it 'keeps a mid-field quote literal' do
+        data = parse("a,b\nab\"c,\"d\"\n", acceleration)
+        expect(data).to eq [{ a: 'ab"c', b: 'd' }]
+      end
+
+      it 'keeps a quote opened mid-field literal across the separator' do
+        data = parse("a,b,c\nx\"y,z\",w\n", acceleration)
+        expect(data).to eq [{ a: 'x"y', b: 'z"', c: 'w' }]
+      end
+
+      it 'treats leading spaces before a quote the same way' do
+        csv = "a,b\n  \"x,y\",z\n"
+        expect(parse(csv, acceleration)).to eq parse(csv, false)
+        expect(parse(csv, acceleration, strip_whitespace: false)).to eq parse(csv, false, strip_whitespace: false)
+      end
+
+      it 'raises on an unclosed quote' do
+        expect { parse("a,b\n\"open,x\n", acceleration) }.to raise_error(SmarterCSV::MalformedCSV)
+      end
+    end
+
+    context 'quote_boundary: :legacy' do
+      it 'toggles quotes anywhere in the field' do
+        data = parse("a,b\nab\"c,d\"e,f\n", acceleration, quote_boundary: :legacy)
+        expect(data).to eq [{ a: 'ab"c,d"e', b: 'f' }]
+      end
+
+      it 'raises on an unclosed quote' do
+        expect { parse("a,b\n\"open,x\n", acceleration, quote_boundary: :legacy) }.to raise_error(SmarterCSV::MalformedCSV)
+      end
+    end
+
+    it 'stops after the last kept column with headers: { only: }' do
+      long = 'v' * 100
+      data = parse("a,b,c\n\"#{long}\",\"x,y\",\"#{long}\"\n", acceleration, headers: { only: %i[a b] })
+      expect(data).to eq [{ a: long, b: 'x,y' }]
+    end
+  end
+end
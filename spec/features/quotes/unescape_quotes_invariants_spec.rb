@@ -155,6 +155,17 @@ end
         expect(array[0].bytesize).to eq(83) # 4×20 + 3 quote chars
       end
 
+      it "round-trips adjacent doubled quotes at the start and end of a long field" do
+        # runs of pairs with no bytes between them, and a pair as the first and last content
+        long_value = '""' + 'j' * 30 + '"' + 'k' * 30 + '""'
+        raw = long_value.gsub('"', '""')
+        line = %{"#{raw}","end"}
+        array, _size = parser.send(:parse, line, options)
+        expect(array).to eq [long_value, 'end']
+        expect(array[0].bytesize).to eq(65)
+        expect(array[0].frozen?).to be(false)
+      end
+
       it "round-trips a long quoted UTF-8 field with multi-byte content" do
         # Each "ä" is 2 bytes UTF-8; 30 × 2 = 60 bytes, >23.
         long_value = 'ä' * 30
@@ -152,6 +152,24 @@ describe 'CSV file with more columns that shown in header' do
         end
       end
 
+      # The C parser caches the key of every column index it has seen; rows that keep getting
+      # wider must still get the same keys as the headers the Reader reports.
+      context "when rows grow wider than any row before them" do
+        let(:csv) { (1..6).map { |i| (1..(i * 3)).to_a.join(',') }.join("\n") + "\n" }
+        let(:reader) do
+          SmarterCSV::Reader.new(StringIO.new(csv), options.merge(headers_in_file: false, user_provided_headers: %i[a b], chunk_size: 2))
+        end
+
+        it "generates each extra column once and keys every row by it" do
+          data = reader.process.flatten
+          expect(reader.headers).to eq %i[a b] + (3..18).map { |i| :"column_#{i}" }
+          data.each_with_index do |row, i|
+            expect(row.keys).to eq reader.headers.first((i + 1) * 3)
+            expect(row.values).to eq (1..((i + 1) * 3)).to_a
+          end
+        end
+      end
+
       context "when user did not provide enough headers manually" do
         before do
           options.merge!(headers_in_file: true, user_provided_headers: %i[a b c d e f])
@@ -0,0 +1,121 @@
+# frozen_string_literal: true
+
+# The C block reader replaces the per-line loop (IO#gets + parse_line_to_hash_ctx_c per
+# physical line) whenever the input allows it. It must produce exactly what the line loop
+# produces — rows, headers, line counters and bad-row records — no matter where the
+# block boundaries fall.
+
+describe 'C block reader' do
+  let(:csv) do
+    "id,name,notes\n" \
+    "1,alice,plain\n" \
+    "2,\"bob, jr\",\"multi\nline\nnote\"\n" \
+    "\n" \
+    "3,carol,\"a \"\"quoted\"\" word\",extra\n" \
+    "4,dave\n" \
+    "5,\"eve\",\"ends\r\nwith crlf\""
+  end
+
+  def line_mode(input, options = {})
+    # comment_regexp keeps the Reader on the line loop (it needs each raw line)
+    reader = SmarterCSV::Reader.new(StringIO.new(input), options.merge(comment_regexp: /(?!)/))
+    [reader.process, reader.headers, reader.file_line_count, reader.csv_line_count, reader.errors]
+  end
+
+  def block_mode(input, options = {})
+    reader = SmarterCSV::Reader.new(StringIO.new(input), options)
+    [reader.process, reader.headers, reader.file_line_count, reader.csv_line_count, reader.errors]
+  end
+
+  [
+    {},
+    { remove_empty_values: false },
+    { remove_empty_hashes: false },
+    { strip_whitespace: false, convert_values_to_numeric: false },
+    { quote_escaping: :double_quotes },
+    { quote_boundary: :legacy },
+    { headers: { only: %i[id notes] } },
+    { with_line_numbers: true },
+  ].each do |options|
+    it "matches the line loop with #{options.inspect}" do
+      expect(block_mode(csv, options)).to eq line_mode(csv, options)
+    end
+  end
+
+  it 'matches the line loop with chunking' do
+    chunks = []
+    SmarterCSV.process(StringIO.new(csv), chunk_size: 2) { |chunk| chunks << chunk.dup }
+    expect(chunks.flatten).to eq line_mode(csv).first
+    expect(chunks.map(&:size)).to eq [2, 2, 1]
+  end
+
+  it 'grows headers for extra columns the same way' do
+    data, headers, = block_mode(csv)
+    expect(headers).to eq %i[id name notes column_4]
+    expect(data[2]).to eq(id: 3, name: 'carol', notes: 'a "quoted" word', column_4: 'extra')
+  end
+
+  it 'raises HeaderSizeMismatch for extra columns with missing_headers: :raise' do
+    expect { block_mode(csv, missing_headers: :raise) }.to raise_error(SmarterCSV::HeaderSizeMismatch, /line 7/)
+  end
+
+  it 'reports an unclosed quote at EOF with the raw row and line counters' do
+    bad = "a,b\n1,2\n3,\"open\nstill open\n"
+    data, _headers, file_lines, _csv_lines, errors = block_mode(bad, on_bad_row: :collect)
+    expect(data).to eq [{ a: 1, b: 2 }]
+    record = errors[:bad_rows].first
+    expect(record[:error_class]).to eq SmarterCSV::MalformedCSV
+    expect(record[:raw_logical_line]).to eq "3,\"open\nstill open\n"
+    expect(record[:file_line_number]).to eq 3
+    expect(record[:file_lines_consumed]).to eq 2
+    expect(file_lines).to eq 4
+    expect(errors[:bad_rows]).to eq line_mode(bad, on_bad_row: :collect).last[:bad_rows]
+  end
+
+  it 'strips a BOM on the first data row when there is no header line' do
+    data, = block_mode("\xEF\xBB\xBFa,b\nc,d\n", headers_in_file: false, user_provided_headers: %i[x y])
+    expect(data).to eq [{ x: 'a', y: 'b' }, { x: 'c', y: 'd' }]
+  end
+
+  it 'leaves a transcoding Zlib::GzipReader to the line loop' do
+    require 'zlib'
+    gzipped = StringIO.new.tap { |io| Zlib::GzipWriter.wrap(io) { |gz| gz.write("id,name\n1,caf\xE9 1\n".b) } }.string
+    [true, false].each do |acceleration|
+      io = Zlib::GzipReader.new(StringIO.new(gzipped), external_encoding: 'windows-1252', internal_encoding: 'utf-8')
+      data = SmarterCSV.process(io, file_encoding: 'windows-1252:utf-8', acceleration: acceleration)
+      expect(data).to eq [{ id: 1, name: 'café 1' }]
+      expect(data[0][:name]).to be_valid_encoding
+    end
+    gz_path = File.join(Dir.tmpdir, "smarter_csv_block_reader_#{Process.pid}.csv.gz")
+    File.binwrite(gz_path, gzipped)
+    expect(SmarterCSV.process(gz_path, file_encoding: 'windows-1252:utf-8')).to eq [{ id: 1, name: 'café 1' }]
+  ensure
+    File.delete(gz_path) if gz_path && File.exist?(gz_path)
+  end
+
+  describe 'block boundaries' do
+    let(:body) do
+      "1,\"x\ny\",z\r\n2,\"\"\"q\"\"\",w\r\n\r\n3,plain,\"a\r\nb\r\nc\"\r\n4,last,row"
+    end
+
+    def read_all(body, block_size)
+      headers = %i[a b c]
+      options = SmarterCSV::Reader.new(StringIO.new(''), row_sep: "\r\n", col_sep: ',').options
+      ctx = SmarterCSV::Parser.new_parse_context_c(headers, options.merge(_keep_cols: false))
+      reader = SmarterCSV::Parser.new_block_reader_c(StringIO.new(body), Encoding::UTF_8, block_size, false)
+      rows = []
+      while (block = SmarterCSV::Parser.read_block_ctx_c(reader, ctx, nil))
+        block.each_slice(3) { |hash, _size, lines| rows << [hash, lines] }
+      end
+      rows
+    end
+
+    it 'returns the same rows for every block size' do
+      expected = read_all(body, 1 << 16)
+      expect(expected.map(&:last)).to eq [1, 1, 1, 3, 1]
+      (1..12).each do |block_size|
+        expect(read_all(body, block_size)).to eq(expected), "block_size #{block_size}"
+      end
+    end
+  end
+end
@@ -0,0 +1,123 @@
+# frozen_string_literal: true
+
+require 'tmpdir'
+require 'fileutils'
+
+# reader.checkpoint records where a chunked read stands after each chunk; resume_from: seeks
+# to that row and continues. Stopping after any chunk and resuming must give the chunks,
+# chunk indexes, line counters and headers of one uninterrupted read.
+
+describe SmarterCSV::Checkpoint do
+  let(:csv) do
+    rows = (0...2_000).map do |i|
+      if (i % 13).zero?
+        "#{i},\"multi\nline #{i}\",#{i * 0.5}"
+      elsif i > 1_500 && (i % 5).zero?
+        "#{i},plain #{i},#{i * 0.5},extra"
+      else
+        "#{i},plain #{i},#{i * 0.5}"
+      end
+    end
+    "\xEF\xBB\xBFid,notes,amount\r\n#{rows.join("\r\n")}\r\n"
+  end
+
+  let(:dir) { Dir.mktmpdir }
+  let(:path) do
+    File.join(dir, 'data.csv').tap { |p| File.binwrite(p, csv) }
+  end
+
+  after { FileUtils.remove_entry(dir) }
+
+  def read_all(options)
+    reader = SmarterCSV::Reader.new(path, options)
+    chunks = []
+    reader.each_chunk { |chunk, index| chunks << [index, chunk] }
+    [chunks, reader.headers, reader.file_line_count, reader.csv_line_count]
+  end
+
+  # reads up to chunk `stop`, then resumes a new reader from the dumped checkpoint
+  def read_resumed(options, stop)
+    reader = SmarterCSV::Reader.new(path, options)
+    chunks = []
+    token = nil
+    reader.each_chunk do |chunk, index|
+      chunks << [index, chunk]
+      token = reader.checkpoint.dump
+      break if index == stop
+    end
+    resumed = SmarterCSV::Reader.new(path, options.merge(resume_from: token))
+    resumed.each_chunk { |chunk, index| chunks << [index, chunk] }
+    [chunks, resumed.headers, resumed.file_line_count, resumed.csv_line_count]
+  end
+
+  [
+    { acceleration: false },
+    {},
+    { parallel: 2 },
+    { io_mode: :mmap },
+    { infer_types: true },
+    { infer_types: true, acceleration: false },
+  ].each do |variant|
+    it "resumes like an uninterrupted read with #{variant}" do
+      options = variant.merge(chunk_size: 150)
+      full = read_all(options)
+      [0, 9, 12].each do |stop|
+        expect(read_resumed(options, stop)).to eq full
+      end
+    end
+  end
+
+  it 'round-trips Symbol and String headers and inferred types' do
+    reader = SmarterCSV::Reader.new(path, chunk_size: 1_900, infer_types: true, strings_as_keys: true)
+    reader.each_chunk { break }
+    loaded = described_class.load(reader.checkpoint.dump)
+    expect(loaded.headers).to eq reader.headers
+    expect(loaded.headers).to eq ['id', 'notes', 'amount', :column_4]
+    expect(loaded.inferred_types).to eq reader.checkpoint.inferred_types
+    expect(loaded.offset).to eq reader.checkpoint.offset
+    expect(loaded.row_sep).to eq "\r\n"
+
+    reader = SmarterCSV::Reader.new(path, chunk_size: 10, acceleration: false)
+    reader.each_chunk { break }
+    expect(described_class.load(reader.checkpoint.to_s).headers).to eq %i[id notes amount]
+  end
+
+  it 'passes the checkpoint to on_chunk' do
+    seen = []
+    SmarterCSV.process(path, chunk_size: 500, on_chunk: ->(info) { seen << info[:checkpoint] }) { |_chunk| nil }
+    expect(seen.size).to eq 4
+    expect(seen.map(&:chunk_count)).to eq [1, 2, 3, 4]
+    expect(seen.last.offset).to eq csv.bytesize
+  end
+
+  it 'resumes a StringIO' do
+    reader = SmarterCSV::Reader.new(StringIO.new(csv), chunk_size: 300)
+    first = nil
+    reader.each_chunk { |chunk| first = chunk and break }
+    rest = SmarterCSV::Reader.new(StringIO.new(csv), chunk_size: 300, resume_from: reader.checkpoint).process
+    expect(first + rest.flatten).to eq SmarterCSV.process(StringIO.new(csv))
+  end
+
+  it 'has no checkpoint without chunk_size or with rows:' do
+    reader = SmarterCSV::Reader.new(path)
+    reader.process
+    expect(reader.checkpoint).to be_nil
+    reader = SmarterCSV::Reader.new(path, chunk_size: 10, rows: 0..50)
+    reader.process
+    expect(reader.checkpoint).to be_nil
+  end
+
+  it 'needs a seekable input to resume' do
+    r, w = IO.pipe
+    w.write(csv)
+    w.close
+    expect { SmarterCSV::Reader.new(r, chunk_size: 10, resume_from: '{}').process }.to raise_error(SmarterCSV::IncorrectOption, /seekable/)
+    r.close
+  end
+
+  it 'rejects invalid checkpoints' do
+    expect { SmarterCSV::Reader.new(path, resume_from: 42) }.to raise_error(SmarterCSV::ValidationError, /invalid resume_from/)
+    expect { SmarterCSV::Reader.new(path, chunk_size: 10, resume_from: 'nope').process }.to raise_error(SmarterCSV::IncorrectOption, /invalid checkpoint/)
+    expect { SmarterCSV::Reader.new(path, chunk_size: 10, resume_from: '{"version":99}').process }.to raise_error(SmarterCSV::IncorrectOption, /version/)
+  end
+end
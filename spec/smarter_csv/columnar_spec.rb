@@ -0,0 +1,121 @@
+# frozen_string_literal: true
+
+begin
+  require 'fiddle'
+rescue LoadError
+  # MemoryView export is then not exercised
+end
+
+# result_format: :columnar returns { header => column }. The columns must hold exactly
+# what pivoting the row hashes would give — one entry per row, nil where a row has no
+# value — whether the rows go straight from the block reader into the column builder
+# or through the row Hash (options that still need Ruby per row).
+
+describe 'result_format: :columnar' do
+  let(:csv) do
+    "id,amount,name,notes,flag\n" \
+    "1,12.5,alice,\"multi\nline\",0\n" \
+    "2,7,bob,,1\n" \
+    ",,,,\n" \
+    "3,,\"carol \"\"c\"\"\",x,0,extra\n" \
+    "4,99999999999999999999,dave,y,1\n"
+  end
+
+  def pivot(rows)
+    columns = {}
+    rows.each_with_index { |hash, i| hash.each { |key, value| (columns[key] ||= [])[i] = value } }
+    columns.each_value { |column| column.fill(nil, column.size...rows.size) }
+  end
+
+  def columnar(input, options = {})
+    SmarterCSV.process(StringIO.new(input), options.merge(result_format: :columnar))
+      .transform_values { |column| column.is_a?(Array) ? column : column.to_a }
+  end
+
+  [
+    {},
+    { remove_empty_values: false },
+    { remove_zero_values: true },
+    { remove_empty_hashes: false },
+    { convert_values_to_numeric: false },
+    { headers: { only: %i[id name] } },
+    { with_line_numbers: true },
+    { value_converters: { name: ->(v) { v.upcase } } },
+    { parallel: 2 },
+  ].each do |options|
+    it "matches the pivoted rows with #{options.inspect}" do
+      expect(columnar(csv, options)).to eq pivot(SmarterCSV.process(StringIO.new(csv), options))
+    end
+  end
+
+  it 'makes the same columns in the same order on the direct and the row Hash paths' do
+    ["a,b,c\n1,,x\n2,,\n", "a,b,c\n1,,x\n2,3,\n"].each do |input|
+      direct = SmarterCSV.process(StringIO.new(input), result_format: :columnar)
+      through_rows = SmarterCSV.process(StringIO.new(input), result_format: :columnar, comment_regexp: /\A#/)
+      plain = SmarterCSV.process(StringIO.new(input), result_format: :columnar, acceleration: false)
+      expect(direct).to eq through_rows
+      expect(direct.keys).to eq plain.keys
+      expect(direct.transform_values(&:to_a)).to eq plain
+    end
+    expect(SmarterCSV.process(StringIO.new("a,b,c\n1,,x\n2,3,\n"), result_format: :columnar).keys).to eq %i[a c b]
+  end
+
+  it 'matches the pivoted rows without acceleration' do
+    expected = pivot(SmarterCSV.process(StringIO.new(csv), acceleration: false))
+    expect(SmarterCSV.process(StringIO.new(csv), acceleration: false, result_format: :columnar)).to eq expected
+  end
+
+  context 'with the C extension', if: SmarterCSV::Parser.respond_to?(:new_column_builder_c) do
+    let(:columns) { SmarterCSV.process(StringIO.new(csv), result_format: :columnar) }
+
+    it 'packs integer columns as int64' do
+      expect(columns[:id]).to be_a SmarterCSV::Column
+      expect(columns[:id].type).to eq :int64
+      expect(columns[:id].to_a).to eq [1, 2, 3, 4] # the blank row is dropped (remove_empty_hashes)
+      expect(columns[:id].null_count).to eq 0
+    end
+
+    it 'turns an integer column that meets a float into float64' do
+      data = SmarterCSV.process(StringIO.new("a\n1\n2.5\n\n-3\n"), result_format: :columnar, remove_empty_hashes: false)
+      expect(data[:a].type).to eq :float64
+      expect(data[:a].to_a).to eq [1.0, 2.5, nil, -3.0]
+      expect(data[:a][-1]).to eq(-3.0)
+      expect(data[:a].size).to eq 4
+      expect(data[:a].null_count).to eq 1
+    end
+
+    it 'keeps other columns as Arrays' do
+      expect(columns[:amount]).to eq [12.5, 7, nil, 99_999_999_999_999_999_999]
+      expect(columns[:name]).to eq ['alice', 'bob', 'carol "c"', 'dave']
+    end
+
+    it 'compares Columns by value' do
+      other = SmarterCSV.process(StringIO.new(csv), result_format: :columnar)
+      expect(columns[:id]).to eq other[:id]
+      expect(columns[:id]).to eql other[:id]
+      expect(columns[:id].hash).to eq other[:id].hash
+      floats = SmarterCSV.process(StringIO.new("id\n1.0\n2\n3\n4\n"), result_format: :columnar)[:id]
+      expect(floats.type).to eq :float64
+      expect(columns[:id]).to eq floats
+      expect(columns[:id]).not_to eql floats
+      expect(columns[:id]).not_to eq SmarterCSV.process(StringIO.new("id\n1\n2\n3\n\n"), result_format: :columnar, remove_empty_hashes: false)[:id]
+    end
+
+    it 'exports packed columns through MemoryView', if: defined?(Fiddle::MemoryView) do
+      view = Fiddle::MemoryView.new(columns[:id])
+      expect([view.format, view.item_size, view.byte_size]).to eq ['q', 8, 32]
+      expect(view[3]).to eq 4
+    end
+  end
+
+  it 'rejects chunk_size' do
+    expect { SmarterCSV.process(StringIO.new(csv), result_format: :columnar, chunk_size: 2) }
+      .to raise_error(SmarterCSV::ValidationError, /columnar/)
+  end
+
+  it 'still yields rows to a block' do
+    rows = []
+    SmarterCSV.process(StringIO.new(csv), result_format: :columnar) { |chunk| rows.concat(chunk) }
+    expect(rows.first).to include(id: 1, name: 'alice')
+  end
+end
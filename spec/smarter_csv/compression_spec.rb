@@ -0,0 +1,113 @@
+# frozen_string_literal: true
+
+require 'tempfile'
+require 'zlib'
+
+# compression: gzip input is inflated by SmarterCSV itself — with the C extension by
+# SmarterCSV::GzipIO (zlib in C, straight into the block reader's buffer), otherwise by
+# Zlib::GzipReader. Either way the rows are those of the uncompressed file.
+
+describe 'compression:' do
+  let(:csv) do
+    rows = (1..20_000).map do |i|
+      notes = (i % 19).zero? ? "\"multi\nline #{i}\"" : "plain #{i}"
+      "#{i},#{i * 0.75},name #{i},#{notes}"
+    end
+    "id,amount,name,notes\n#{rows.join("\n")}\n"
+  end
+
+  def gzip_file(content)
+    Tempfile.create(['compression', '.csv.gz']) do |file|
+      file.binmode
+      file.write(Zlib.gzip(content))
+      file.close
+      yield file.path
+    end
+  end
+
+  def read(input, options = {})
+    reader = SmarterCSV::Reader.new(input, options)
+    [reader.process, reader.headers, reader.file_line_count, reader.csv_line_count]
+  end
+
+  let(:expected) { read(StringIO.new(csv)) }
+
+  [true, false].each do |bool|
+    context "with#{bool ? ' C-' : 'out '}acceleration" do
+      it 'detects a gzip file by its magic bytes' do
+        gzip_file(csv) { |path| expect(read(path, acceleration: bool)).to eq expected }
+      end
+
+      it 'detects a gzip File input' do
+        gzip_file(csv) { |path| File.open(path, 'rb') { |f| expect(read(f, acceleration: bool)).to eq expected } }
+      end
+
+      it 'reads through the line loop the same' do
+        gzip_file(csv) do |path|
+          expect(read(path, acceleration: bool, comment_regexp: /\A#/)).to eq read(StringIO.new(csv), comment_regexp: /\A#/)
+        end
+      end
+
+      it 'raises Zlib::GzipFile::Error on a truncated file' do
+        Tempfile.create(['truncated', '.csv.gz']) do |file|
+          data = Zlib.gzip(csv)
+          file.binmode
+          file.write(data.byteslice(0, data.bytesize / 2))
+          file.close
+          expect { SmarterCSV.process(file.path, acceleration: bool) }.to raise_error(Zlib::GzipFile::Error, /unexpected end of file/)
+        end
+      end
+    end
+  end
+
+  it 'reads a gzip pipe with compression: :gzip' do
+    r, w = IO.pipe
+    w.binmode
+    writer = Thread.new do
+      w.write(Zlib.gzip(csv))
+      w.close
+    end
+    expect(read(r, compression: :gzip)[0]).to eq expected[0]
+    writer.join
+  end
+
+  it 'combines with parallel: N and infer_types' do
+    gzip_file(csv) do |path|
+      expect(read(path, parallel: 3, infer_types: true)).to eq read(StringIO.new(csv), infer_types: true)
+    end
+  end
+
+  it 'leaves the input alone with compression: :none' do
+    gzip_file("a,b\n1,2\n") do |path|
+      expect(SmarterCSV.process(path, compression: :none, row_sep: "\n", col_sep: ',')).not_to eq [{ a: 1, b: 2 }]
+    end
+  end
+
+  it 'rejects an unknown compression' do
+    expect { SmarterCSV.process(StringIO.new("a\n1\n"), compression: :zstd) }.to raise_error(SmarterCSV::ValidationError, /compression/)
+  end
+
+  if defined?(SmarterCSV::GzipIO)
+    describe SmarterCSV::GzipIO do
+      it 'answers gets, read, rewind and eof? like Zlib::GzipReader' do
+        gzip_file(csv) do |path|
+          File.open(path, 'rb') do |f|
+            io = SmarterCSV::Parser.new_gzip_io_c(f, f.fileno, Encoding::UTF_8)
+            expect(io.gets("\n")).to eq "id,amount,name,notes\n"
+            expect(io.read(5)).to eq '1,0.7'
+            expect(io.pos).to eq 26
+            io.rewind
+            expect(io.gets("\n").encoding).to eq Encoding::UTF_8
+            expect(io.read).to eq csv.byteslice(21..)
+            expect(io.eof?).to be true
+            expect(io.read(1)).to be_nil
+            io.rewind
+            expect(io.gets(nil)).to eq csv
+            io.close
+            expect(f).to be_closed
+          end
+        end
+      end
+    end
+  end
+end
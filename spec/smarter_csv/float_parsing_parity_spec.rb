@@ -11,6 +11,7 @@ require 'bigdecimal'
 #   :bigdecimal -> always BigDecimal (== BigDecimal(str))
 #   :auto       -> Float unless the value carries more than 16 significant digits,
 #                  then BigDecimal (no precision loss)
+#   :rational   -> always Rational (exact; == String#to_r)
 #
 # Integers stay Integer in every mode. Values that are not numbers (a bare ".5" or "5.",
 # which the shared grammar rejects) stay String. Every case runs on both paths via
@@ -76,8 +77,22 @@ HIGH_PRECISION_DECIMALS = %w[
       end
     end
 
+    describe 'decimal_precision: :rational' do
+      (LOW_PRECISION_DECIMALS + HIGH_PRECISION_DECIMALS + %w[-0.0 12.50 0.000000000000000000001]).each do |str|
+        it "parses #{str} as a Rational equal to String#to_r" do
+          v = parse(str, acceleration: acceleration, decimal_precision: :rational)
+          expect(v).to be_a(Rational)
+          expect(v).to eq(str.to_r)
+        end
+      end
+
+      it "keeps an exponent past 1_000_000 a Float" do
+        expect(parse('1e1000001', acceleration: acceleration, decimal_precision: :rational)).to eql(Float::INFINITY)
+      end
+    end
+
     describe 'integers stay Integer in every mode' do
-      %i[float auto bigdecimal].each do |mode|
+      %i[float auto bigdecimal rational].each do |mode|
         it "parses 42 as Integer under #{mode}" do
           expect(parse('42', acceleration: acceleration, decimal_precision: mode)).to eql(42)
         end
@@ -125,11 +140,60 @@ describe 'Eisel-Lemire fast path: 18-19 significant digits, decimal_precision: :
   end
 end
 
+# Past 19 digits the C path rounds the first 19 digits and that value + 1; when both give
+# the same double it needs no strtod. Integers past 18 digits are built from their digits.
+# Both must match String#to_f / String#to_i exactly, including values on a rounding boundary.
+TRUNCATED_MANTISSA_DECIMALS = %w[
+  12345678901234567890.123456789
+  0.12345678901234567890123456789
+  -98765432109876543210.5
+  9007199254740993.0000000000001
+  9007199254740992.99999999999999
+  1.00000000000000011102230246251565404236316680908203125
+  1.000000000000000111022302462515654042363166809082031251
+  123456789012345678901234567890e-40
+].freeze
+
+BIGNUM_INTEGERS = %w[
+  1234567890123456789
+  9223372036854775808
+  -9223372036854775809
+  18446744073709551616
+  123456789012345678901234567890
+  -000000000000000000000000000042
+  00000000000000000000
+].push('9' * 400).freeze
+
+describe 'more than 19 digits, without a temporary String' do
+  [true, false].each do |acceleration|
+    TRUNCATED_MANTISSA_DECIMALS.each do |str|
+      it "correctly rounds #{str} under decimal_precision: :float (#{acceleration ? 'C' : 'Ruby'} path)" do
+        v = SmarterCSV.process(StringIO.new("a,b\n#{str},x\n"), acceleration: acceleration, decimal_precision: :float)[0][:a]
+        expect(v).to be_a(Float)
+        expect(v).to eql(str.to_f)
+      end
+    end
+
+    BIGNUM_INTEGERS.each do |str|
+      it "parses #{str[0, 40]} as String#to_i (#{acceleration ? 'C' : 'Ruby'} path)" do
+        v = SmarterCSV.process(StringIO.new("a,b\n#{str},x\n"), acceleration: acceleration)[0][:a]
+        expect(v).to be_a(Integer)
+        expect(v).to eq(str.to_i)
+      end
+    end
+  end
+end
+
 # Explicit C-vs-Ruby parity sweep across all modes — any divergence trips here.
 describe 'numeric conversion: C and Ruby paths agree' do
+  # Digit runs of 7, 8, 9, 16 and 17+ bytes cross the word (8-byte) and vector (16-byte)
+  # steps of the C digit scan, with leading zeros and digits past the 19-digit mantissa.
   samples = LOW_PRECISION_DECIMALS + HIGH_PRECISION_DECIMALS +
-            %w[42 -7 0 .5 5. 1_000 abc]
-  %i[float auto bigdecimal].each do |mode|
+            %w[42 -7 0 .5 5. 1_000 abc
+               1234567 12345678 123456789 1234567890123456 12345678901234567 123456789012345678901234
+               00000000000000000042 0.00000000000000001234 12345678.1234567 1234567812345678.5
+               123456781234567812345678.25 1234567x 12345678x9 1234567812345678x 12345678e8 1234567812345678e-30]
+  %i[float auto bigdecimal rational].each do |mode|
     samples.each do |str|
       it "#{str.inspect} parses identically under #{mode}" do
         csv = "a,b\n#{str},x\n"
@@ -0,0 +1,89 @@
+# frozen_string_literal: true
+
+# infer_types reads ahead, types each column from the values of the sampled rows, and
+# converts every row by those types — the C parser through its column plan, the Ruby path
+# in hash_transformations. The sampled rows are replayed through the main loop, so line
+# counters, bad rows and chunking must be exactly what they are without infer_types.
+
+describe 'infer_types' do
+  let(:csv) do
+    "id,price,big,active,day,name,code\n" \
+    "1,1.5,12345678901234567890.5,true,2024-01-31,alice,007\n" \
+    "2,2,1.25,FALSE,2024-02-29,bob,x1\n" \
+    "3,,3,,,\"carol\nc\",\n" \
+    "4,7,8,maybe,2024-13-01,dave,9\n"
+  end
+
+  def read(input, options = {})
+    reader = SmarterCSV::Reader.new(StringIO.new(input), options)
+    [reader.process, reader.inferred_types, reader.file_line_count, reader.csv_line_count, reader.errors]
+  end
+
+  [true, false].each do |acceleration|
+    context "with acceleration: #{acceleration}" do
+      it 'types the columns from the sample' do
+        _rows, types, = read(csv, acceleration: acceleration, infer_types: true)
+        expect(types).to eq(id: :integer, price: :float, big: :decimal, active: :string, day: :string, name: :string, code: :string)
+      end
+
+      it 'converts rows after the sample by type, keeping a value that does not fit as a String' do
+        rows, types, = read(csv, acceleration: acceleration, infer_types: 2)
+        expect(types).to include(active: :boolean, day: :date, code: :string)
+        expect(rows[0]).to include(price: 1.5, big: BigDecimal('12345678901234567890.5'), active: true, day: Date.new(2024, 1, 31), code: '007')
+        expect(rows[1]).to include(price: 2.0, active: false, day: Date.new(2024, 2, 29))
+        expect(rows[1][:price]).to be_a Float
+        expect(rows[2]).to include(big: BigDecimal('3'), name: "carol\nc")
+        expect(rows[3]).to include(price: 7.0, active: 'maybe', day: '2024-13-01', code: '9')
+      end
+
+      it 'keeps line counters and bad rows' do
+        input = "#{csv}5,\"open\n"
+        with = read(input, acceleration: acceleration, infer_types: true, on_bad_row: :collect)
+        without = read(input, acceleration: acceleration, on_bad_row: :collect)
+        expect(with[2..]).to eq without[2..]
+      end
+
+      it 'keeps the rows after a sampled multiline row over field_size_limit' do
+        input = "a,b\n1,\"#{'x' * 50}\n#{'y' * 50}\nz\"\n2,ok\n"
+        options = { acceleration: acceleration, field_size_limit: 60, on_bad_row: :collect }
+        with = read(input, options.merge(infer_types: 10))
+        without = read(input, options)
+        expect(with[0].map { |row| row[:b] }).to eq [nil, 'ok']
+        expect(with[0].map { |row| row[:a].to_s }).to eq without[0].map { |row| row[:a].to_s }
+        expect(with[2..]).to eq without[2..]
+      end
+
+      it 'combines with Symbol value_converters, which override the inferred type' do
+        input = "a,b,c\n$1.50,x,1\n\"(2,000)\",y,2\n"
+        rows, types, = read(input, acceleration: acceleration, infer_types: true,
+                                   value_converters: { a: :money, c: ->(v) { v * 10 } })
+        expect(types).to include(a: :string, c: :integer)
+        expect(rows).to eq [{ a: BigDecimal('1.5'), b: 'x', c: 10 }, { a: BigDecimal('-2000'), b: 'y', c: 20 }]
+      end
+    end
+  end
+
+  {
+    { parallel: 2 }              => ->(rows) { rows },
+    { chunk_size: 3 }            => ->(chunks) { chunks.flatten(1) },
+    { rows_as: :arrays }         => ->(rows) { rows.map { |row| row.fill(nil, row.size...7) } },
+    { result_format: :columnar } => ->(columns) { columns[:price].to_a },
+  }.each do |options, normalize|
+    it "types the same way with #{options.inspect}" do
+      rows, types, = read(csv, { infer_types: 2 }.merge(options))
+      expected, expected_types, = read(csv, infer_types: 2)
+      expect(types).to eq expected_types
+      expected =
+        case options.keys.first
+        when :rows_as then expected.map { |row| %i[id price big active day name code].map { |key| row[key] } }
+        when :result_format then expected.map { |row| row[:price] }
+        else expected
+        end
+      expect(normalize.call(rows)).to eq expected
+    end
+  end
+
+  it 'rejects an invalid sample size' do
+    expect { SmarterCSV.process(StringIO.new(csv), infer_types: 0) }.to raise_error(SmarterCSV::ValidationError, /infer_types/)
+  end
+end
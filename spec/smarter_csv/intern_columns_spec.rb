@@ -0,0 +1,58 @@
+# frozen_string_literal: true
+
+# intern_columns: the String values of the listed columns are frozen and deduplicated, so
+# every row holding the same value shares one String object.
+
+describe 'intern_columns' do
+  let(:csv) do
+    "country,status,amount\n" \
+    "US,\"ok\",1\n" \
+    "US,\"o\"\"k\",2\n" \
+    "DE,ok,3\n" \
+    "US,ok,4,US\n"
+  end
+
+  def column(rows, key)
+    rows.map { |row| row[key] }
+  end
+
+  [true, false].each do |acceleration|
+    context "with acceleration: #{acceleration}" do
+      it 'shares one frozen String per value in the listed columns' do
+        rows = SmarterCSV.process(StringIO.new(csv), acceleration: acceleration, intern_columns: :country)
+        countries = column(rows, :country)
+        expect(countries).to eq %w[US US DE US]
+        expect(countries).to all(be_frozen)
+        expect(countries[0]).to equal countries[1]
+        expect(countries[0]).to equal countries[3]
+        expect(column(rows, :status).map(&:frozen?)).to eq [false] * 4
+      end
+
+      it 'interns unescaped quoted values and extra columns' do
+        rows = SmarterCSV.process(StringIO.new(csv), acceleration: acceleration, intern_columns: %i[status column_4])
+        statuses = column(rows, :status)
+        expect(statuses).to eq ['ok', 'o"k', 'ok', 'ok']
+        expect(statuses[0]).to equal statuses[2]
+        expect(statuses[1]).to be_frozen
+        expect(rows.last[:column_4]).to be_frozen
+      end
+
+      it 'interns every column with true, and leaves numbers alone' do
+        rows = SmarterCSV.process(StringIO.new(csv), acceleration: acceleration, intern_columns: true)
+        expect(column(rows, :status)).to all(be_frozen)
+        expect(column(rows, :amount)).to eq [1, 2, 3, 4]
+      end
+    end
+  end
+
+  it 'interns with rows_as: :arrays and result_format: :columnar' do
+    arrays = SmarterCSV.process(StringIO.new(csv), intern_columns: :country, rows_as: :arrays)
+    expect(arrays[0][0]).to equal arrays[1][0]
+    columns = SmarterCSV.process(StringIO.new(csv), intern_columns: :country, result_format: :columnar)
+    expect(columns[:country][0]).to equal columns[:country][3]
+  end
+
+  it 'rejects an invalid value' do
+    expect { SmarterCSV.process(StringIO.new(csv), intern_columns: 1) }.to raise_error(SmarterCSV::ValidationError, /intern_columns/)
+  end
+end
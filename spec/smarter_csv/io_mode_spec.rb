@@ -0,0 +1,74 @@
+# frozen_string_literal: true
+
+require 'tempfile'
+
+# io_mode: :mmap parses a file path from a read-only mapping instead of #read-ing it into
+# the block reader's buffer. It must be invisible in the results: rows, headers, line
+# counters and bad rows are exactly those of io_mode: :read.
+
+describe 'io_mode: :mmap' do
+  let(:csv) do
+    rows = (1..20_000).map do |i|
+      notes = (i % 13).zero? ? "\"multi\nline #{i}\"" : "plain #{i}"
+      "#{i},#{i * 0.25},name #{i},#{notes}"
+    end
+    "id,amount,name,notes\n#{rows.join("\n")}\n"
+  end
+
+  def with_file(content)
+    file = Tempfile.new(['io_mode', '.csv'])
+    file.binmode
+    file.write(content)
+    file.close
+    yield file.path
+  ensure
+    file&.close!
+  end
+
+  def read(path, options = {})
+    reader = SmarterCSV::Reader.new(path, options)
+    [reader.process, reader.headers, reader.file_line_count, reader.csv_line_count, reader.errors]
+  end
+
+  [
+    {},
+    { parallel: 4 },
+    { infer_types: true },
+    { headers_in_file: false, user_provided_headers: %i[a b c d] },
+    { chunk_size: 1000 },
+  ].each do |options|
+    it "matches io_mode: :read with #{options.inspect}" do
+      with_file(csv) do |path|
+        expect(read(path, options.merge(io_mode: :mmap))).to eq read(path, options)
+      end
+    end
+  end
+
+  it 'strips a BOM and reads a last row without a row separator' do
+    with_file("\xEF\xBB\xBFa,b\n1,2\n3,4") do |path|
+      expect(read(path, io_mode: :mmap, headers_in_file: false, user_provided_headers: %i[x y]))
+        .to eq read(path, headers_in_file: false, user_provided_headers: %i[x y])
+      expect(SmarterCSV.process(path, io_mode: :mmap)).to eq [{ a: 1, b: 2 }, { a: 3, b: 4 }]
+    end
+  end
+
+  it 'collects bad rows like io_mode: :read' do
+    with_file("a,b\n1,2\n3,\"open\n4,5\n") do |path|
+      expect(read(path, io_mode: :mmap, on_bad_row: :collect)).to eq read(path, on_bad_row: :collect)
+    end
+  end
+
+  it 'handles a file with a header only' do
+    with_file("a,b\n") do |path|
+      expect(SmarterCSV.process(path, io_mode: :mmap)).to eq []
+    end
+  end
+
+  it 'reads IO inputs as with io_mode: :read' do
+    expect(SmarterCSV.process(StringIO.new("a,b\n1,2\n"), io_mode: :mmap)).to eq [{ a: 1, b: 2 }]
+  end
+
+  it 'rejects an unknown io_mode' do
+    expect { SmarterCSV.process(StringIO.new("a\n1\n"), io_mode: :stream) }.to raise_error(SmarterCSV::ValidationError, /io_mode/)
+  end
+end
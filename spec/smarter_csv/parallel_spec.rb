@@ -0,0 +1,60 @@
+# frozen_string_literal: true
+
+# parallel: N splits each block of the block reader between N threads. Slices after the
+# first start at a row boundary speculated from the quote parity at the cut, which is
+# wrong when a quote does not toggle quoting (backslash escapes, stray quotes in unquoted
+# fields) — those slices are re-scanned. Whatever the cuts, the result must be exactly
+# the sequential one: rows, their order, headers and line counters.
+
+describe 'parallel: N' do
+  let(:csv) do
+    rows = (1..6000).map do |i|
+      notes = (i % 7).zero? ? "\"multi\nline #{i}\nnote\"" : "plain #{i}"
+      quoted = (i % 11).zero? ? '"say ""hi"""' : ''
+      extra = (i % 997).zero? ? ',extra' : ''
+      "#{i},#{i * 1.5},name #{i},#{notes},#{quoted}#{extra}"
+    end
+    "id,amount,name,notes,quoted\n#{rows.join("\n")}\n"
+  end
+
+  def read(input, options = {})
+    reader = SmarterCSV::Reader.new(StringIO.new(input), options)
+    [reader.process, reader.headers, reader.file_line_count, reader.csv_line_count, reader.errors]
+  end
+
+  [
+    {},
+    { quote_escaping: :double_quotes },
+    { remove_empty_values: false, convert_values_to_numeric: false },
+    { headers: { only: %i[id notes] } },
+    { with_line_numbers: true },
+  ].each do |options|
+    it "matches the sequential parse with #{options.inspect}" do
+      expect(read(csv, options.merge(parallel: 4))).to eq read(csv, options)
+    end
+  end
+
+  it 'grows headers for extra columns in row order' do
+    _data, headers, = read(csv, parallel: 3)
+    expect(headers).to eq %i[id amount name notes quoted column_6]
+  end
+
+  it 'matches the sequential parse with backslash escapes and an unclosed quote at EOF' do
+    body = (1..4000).map { |i| "#{i},\"v\\\"#{i}\",#{(i % 9).zero? ? "\"m\nl\\\"\n\"" : 'y'}" }.join("\n")
+    input = "a,b,c\n#{body}\n9,\"open\nstill open"
+    expect(read(input, parallel: 4, on_bad_row: :collect)).to eq read(input, on_bad_row: :collect)
+  end
+
+  it 'matches the sequential parse with stray quotes in unquoted fields' do
+    body = (1..6000).map { |i| "#{i},#{(i % 13).zero? ? "5'1#{i % 10}\" tall" : 'short'},\"multi\nline #{i}\"" }.join("\n")
+    input = "id,height,notes\n#{body}\n"
+    expect(read(input, parallel: 4)).to eq read(input)
+    expect(read(input, parallel: 4).first.size).to eq 6000
+  end
+
+  it 'rejects a thread count outside 1..64' do
+    expect { SmarterCSV.process(StringIO.new(csv), parallel: 0) }.to raise_error(SmarterCSV::ValidationError, /parallel/)
+    expect { SmarterCSV.process(StringIO.new(csv), parallel: 65) }.to raise_error(SmarterCSV::ValidationError, /1 to 64/)
+    expect(SmarterCSV.process(StringIO.new(csv), parallel: 64)).to eq SmarterCSV.process(StringIO.new(csv))
+  end
+end
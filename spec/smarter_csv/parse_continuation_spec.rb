@@ -0,0 +1,78 @@
+# frozen_string_literal: true
+
+# A row with a multiline quoted field comes back as data_size -1 until its closing quote
+# has been read. With a continuation object the C parser keeps its state at the -1 exit,
+# and the next call on the same String (grown by the next physical line) continues the
+# scan there. The results must be exactly those of re-parsing the whole stitched row.
+
+describe 'C parse continuation' do
+  before do
+    skip 'C extension not loaded' unless SmarterCSV::Parser.respond_to?(:new_parse_continuation_c)
+  end
+
+  let(:headers) { %i[a b c] }
+
+  def context(options = {})
+    opts = SmarterCSV::Reader.new(StringIO.new(''), { row_sep: "\n", col_sep: ',' }.merge(options)).options
+    SmarterCSV::Parser.new_parse_context_c(headers.dup, opts.merge(_keep_cols: false))
+  end
+
+  def stitched_results(lines, options)
+    full_ctx = context(options)
+    cont_ctx = context(options)
+    cont = SmarterCSV::Parser.new_parse_continuation_c
+    row = +''
+    lines.map do |line|
+      row << line
+      [SmarterCSV::Parser.parse_line_to_hash_ctx_c(row.dup, full_ctx),
+       SmarterCSV::Parser.parse_line_to_hash_ctx_c(row, cont_ctx, cont)]
+    end
+  end
+
+  [
+    { quote_escaping: :double_quotes },
+    { quote_escaping: :backslash },
+    { quote_escaping: :double_quotes, quote_boundary: :legacy },
+    { quote_escaping: :double_quotes, strip_whitespace: false },
+  ].each do |options|
+    it "matches a full re-parse at every line with #{options.inspect}" do
+      lines = [
+        "1,  \"first\n",
+        "second \"\"quoted\"\"\n",
+        "third, with comma\\\n",
+        "\",\"x\n",
+        "y\"\n",
+      ]
+      results = stitched_results(lines, options)
+      results.each { |full, resumed| expect(resumed).to eq full }
+      expect(results.first.last.last).to eq(-1) unless options[:strip_whitespace] == false
+      expect(results.last.last.last).not_to eq(-1)
+    end
+  end
+
+  it 'starts over for a different String' do
+    ctx = context(quote_escaping: :double_quotes)
+    cont = SmarterCSV::Parser.new_parse_continuation_c
+    expect(SmarterCSV::Parser.parse_line_to_hash_ctx_c(+"1,\"open\n", ctx, cont)).to eq [nil, -1]
+    expect(SmarterCSV::Parser.parse_line_to_hash_ctx_c(+"2,x,y\n", ctx, cont)).to eq [{ a: 2, b: 'x', c: 'y' }, 3]
+  end
+
+  it 'keeps the partial row across GC' do
+    ctx = context(quote_escaping: :double_quotes)
+    cont = SmarterCSV::Parser.new_parse_continuation_c
+    row = +"#{'v' * 40},\"open\n"
+    expect(SmarterCSV::Parser.parse_line_to_hash_ctx_c(row, ctx, cont)).to eq [nil, -1]
+    GC.start
+    GC.compact if GC.respond_to?(:compact)
+    row << "closed\",z\n"
+    expect(SmarterCSV::Parser.parse_line_to_hash_ctx_c(row, ctx, cont)).to eq [{ a: 'v' * 40, b: "open\nclosed", c: 'z' }, 3]
+  end
+
+  it 'parses files with many-line fields the same in the Reader' do
+    csv = "id,address\n" + Array.new(3) { |i| "#{i},\"#{Array.new(25) { |k| "l#{k} \"\"#{i}\"\" end" }.join("\n")}\"\n" }.join
+    c_data    = SmarterCSV.process(StringIO.new(csv), acceleration: true)
+    ruby_data = SmarterCSV.process(StringIO.new(csv), acceleration: false)
+    expect(c_data).to eq ruby_data
+    expect(c_data.first[:address].lines.size).to eq 25
+  end
+end
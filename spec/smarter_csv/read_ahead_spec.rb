@@ -0,0 +1,88 @@
+# frozen_string_literal: true
+
+require 'tempfile'
+
+# read_ahead: N reads the blocks of an fd-backed input on a native thread while the rows
+# of the previous block are parsed. What Ruby buffered before the block reader took over
+# (PeekableIO's detection buffer, the IO's own buffer) must come first, and the rows must
+# be exactly those of a read without it.
+
+describe 'read_ahead:' do
+  let(:csv) do
+    rows = (1..30_000).map do |i|
+      notes = (i % 17).zero? ? "\"multi\nline #{i}\"" : "plain #{i}"
+      "#{i},#{i * 0.5},name #{i},#{notes}"
+    end
+    "\xEF\xBB\xBFid,amount,name,notes\n#{rows.join("\n")}\n"
+  end
+
+  def read(input, options = {})
+    reader = SmarterCSV::Reader.new(input, options)
+    [reader.process, reader.headers, reader.file_line_count, reader.csv_line_count, reader.errors]
+  end
+
+  def pipe_of(content)
+    r, w = IO.pipe
+    writer = Thread.new do
+      w.write(content)
+      w.close
+    end
+    [r, writer]
+  end
+
+  let(:expected) { read(StringIO.new(csv)) }
+
+  [true, 1, 4].each do |read_ahead|
+    it "reads a file the same with read_ahead: #{read_ahead}" do
+      Tempfile.create(['read_ahead', '.csv']) do |file|
+        file.binmode
+        file.write(csv)
+        file.close
+        expect(read(file.path, read_ahead: read_ahead)).to eq expected
+      end
+    end
+
+    it "reads a pipe the same with read_ahead: #{read_ahead}" do
+      r, writer = pipe_of(csv)
+      expect(read(r, read_ahead: read_ahead)).to eq expected
+      writer.join
+    end
+  end
+
+  it 'combines with parallel: N and chunk_size' do
+    r, writer = pipe_of(csv)
+    expect(read(r, read_ahead: true, parallel: 3, chunk_size: 500)).to eq read(StringIO.new(csv), chunk_size: 500)
+    writer.join
+  end
+
+  it 'reads a pipe with nothing after the header' do
+    r, writer = pipe_of("a,b\n")
+    expect(SmarterCSV.process(r, read_ahead: true)).to eq []
+    writer.join
+  end
+
+  it 'stops the prefetch thread when processing ends early' do
+    r, w = IO.pipe
+    writer = Thread.new do
+      w.write("a,b\n")
+      loop { w.write("1,2\n" * 1000) }
+    rescue IOError, Errno::EPIPE
+      # the reader closed the pipe
+    end
+    chunks = 0
+    expect do
+      SmarterCSV.process(r, read_ahead: true, chunk_size: 10) { |_chunk| raise ArgumentError, 'done' if (chunks += 1) > 3 }
+    end.to raise_error(ArgumentError, 'done')
+    expect(r).to be_closed
+    w.close
+    writer.join
+  end
+
+  it 'reads StringIO inputs as without read_ahead' do
+    expect(read(StringIO.new(csv), read_ahead: true)).to eq expected
+  end
+
+  it 'rejects an invalid value' do
+    expect { SmarterCSV.process(StringIO.new("a\n1\n"), read_ahead: 0) }.to raise_error(SmarterCSV::ValidationError, /read_ahead/)
+  end
+end
@@ -0,0 +1,122 @@
+# frozen_string_literal: true
+
+require 'tmpdir'
+require 'fileutils'
+
+# SmarterCSV.build_index writes a sidecar with the byte offset of every Nth data row;
+# rows: returns a slice of the data rows, and with index: the reader seeks close to its
+# start first. The slice, and the line counters, must be exactly those of reading the
+# whole file and dropping the other rows.
+
+describe 'SmarterCSV.build_index and rows:' do
+  let(:csv) do
+    rows = (0...3_000).map do |i|
+      if (i % 7).zero?
+        "#{i},\"multi\nline \"\"#{i}\"\"\",x"
+      elsif (i % 11).zero?
+        ''
+      else
+        "#{i},plain #{i},y"
+      end
+    end
+    "\xEF\xBB\xBFid,notes,tag\n#{rows.join("\n")}\n"
+  end
+
+  let(:dir) { Dir.mktmpdir }
+  let(:path) do
+    File.join(dir, 'data.csv').tap { |p| File.binwrite(p, csv) }
+  end
+
+  after { FileUtils.remove_entry(dir) }
+
+  def read(options)
+    reader = SmarterCSV::Reader.new(path, options)
+    [reader.process, reader.csv_line_count, reader.file_line_count, reader.warnings]
+  end
+
+  [true, false].each do |acceleration|
+    context "with#{acceleration ? '' : 'out'} acceleration" do
+      let(:options) { { acceleration: acceleration } }
+
+      it 'writes the sidecar next to the file' do
+        expect(SmarterCSV.build_index(path, options.merge(index_every: 100))).to eq "#{path}.csvidx"
+        index = SmarterCSV::RowIndex.load("#{path}.csvidx")
+        expect(index.row_count).to eq 3_000
+        expect(index.entries.size).to eq 30
+        # row 0 starts right after the BOM and header
+        expect(index.entries.first).to eq ["\xEF\xBB\xBFid,notes,tag\n".bytesize, 0]
+      end
+
+      [0..5, 1_234..1_300, 2_990.., 500...500, 99..101].each do |rows|
+        it "reads rows #{rows} as a full read would, with and without the index" do
+          SmarterCSV.build_index(path, options.merge(index_every: 100))
+          all = SmarterCSV::Reader.new(path, options.merge(remove_empty_hashes: false, remove_empty_values: false)).process
+          expected = all[rows].reject { |h| h.values.all? { |v| v.nil? || v == '' } }
+
+          with_index = read(options.merge(rows: rows, index: true))
+          without = read(options.merge(rows: rows))
+          expect(with_index[0].map { |h| h[:id] }).to eq expected.map { |h| h[:id] }
+          expect(with_index[0..2]).to eq without[0..2]
+          expect(with_index[3]).to eq []
+        end
+      end
+    end
+  end
+
+  it 'finds the same rows with the C scan and the Ruby line loop' do
+    skip 'C extension not available' unless SmarterCSV::Parser.respond_to?(:row_index_c)
+
+    SmarterCSV.build_index(path, index_every: 10)
+    c_index = SmarterCSV::RowIndex.load("#{path}.csvidx")
+    SmarterCSV.build_index(path, index_every: 10, acceleration: false)
+    ruby_index = SmarterCSV::RowIndex.load("#{path}.csvidx")
+    expect(c_index.entries).to eq ruby_index.entries
+    expect(c_index.row_count).to eq ruby_index.row_count
+  end
+
+  it 'reads from the first row with a warning when the file changed' do
+    SmarterCSV.build_index(path)
+    File.open(path, 'ab') { |f| f.write("9999,late,z\n") }
+    data, _, _, warnings = read(rows: 2_995.., index: true)
+    expect(data.map { |h| h[:id] }).to eq [2_995, 2_996, 2_997, 2_998, 2_999, 9_999]
+    expect(warnings.map { |w| w[:code] }).to eq [:stale_index]
+  end
+
+  it 'does not use an index built with other options' do
+    SmarterCSV.build_index(path, quote_boundary: :legacy)
+    _, _, _, warnings = read(rows: 10..12, index: true)
+    expect(warnings.map { |w| w[:code] }).to eq [:stale_index]
+  end
+
+  it 'warns when there is no index' do
+    data, _, _, warnings = read(rows: 3..4, index: true)
+    expect(data.map { |h| h[:id] }).to eq [3, 4]
+    expect(warnings.map { |w| w[:code] }).to eq [:no_index]
+  end
+
+  it 'takes the sidecar path as index:' do
+    sidecar = File.join(dir, 'other.idx')
+    expect(SmarterCSV.build_index(path, index: sidecar)).to eq sidecar
+    data, _, _, warnings = read(rows: 2_000..2_001, index: sidecar)
+    expect(data.map { |h| h[:id] }).to eq [2_000, 2_001]
+    expect(warnings).to eq []
+  end
+
+  it 'combines rows: with chunk_size and result_format: :columnar' do
+    chunks = SmarterCSV.process(path, rows: 100..119, chunk_size: 8)
+    expect(chunks.flatten.map { |h| h[:id] }).to eq (100..119).to_a - [110]
+    columns = SmarterCSV.process(path, rows: 100..119, result_format: :columnar)
+    expect(columns[:id].to_a).to eq (100..119).to_a - [110]
+  end
+
+  it 'needs a file path to build an index' do
+    expect { SmarterCSV.build_index(StringIO.new(csv)) }.to raise_error(SmarterCSV::IncorrectOption, /file path/)
+  end
+
+  it 'rejects invalid options' do
+    expect { SmarterCSV::Reader.new(path, rows: 5) }.to raise_error(SmarterCSV::ValidationError, /invalid rows/)
+    expect { SmarterCSV::Reader.new(path, rows: -1..3) }.to raise_error(SmarterCSV::ValidationError, /invalid rows/)
+    expect { SmarterCSV::Reader.new(path, index: :yes) }.to raise_error(SmarterCSV::ValidationError, /invalid index/)
+    expect { SmarterCSV::Reader.new(path, index_every: 0) }.to raise_error(SmarterCSV::ValidationError, /invalid index_every/)
+  end
+end
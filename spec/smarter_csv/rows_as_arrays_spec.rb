@@ -0,0 +1,83 @@
+# frozen_string_literal: true
+
+# rows_as: :arrays returns each row as an Array of values aligned to reader.headers. With
+# the C extension the parser builds the Array directly instead of a row Hash, so every
+# option that the hash path handles per key has to come out the same by position: each
+# row must equal the hash row looked up with values_at(*reader.headers). (Rows read before
+# an extra column turns up end before it, like their hashes lack its key.)
+
+describe 'rows_as: :arrays' do
+  let(:csv) do
+    "id,amount,name,notes,flag\n" \
+    "1,12.5,alice,\"multi\nline\",0\n" \
+    "2,7,bob,,1\n" \
+    ",,,,\n" \
+    "3,,\"carol \"\"c\"\"\",x,0,extra\n" \
+    "4,99999999999999999999,dave,NA,1\n" \
+    "5\n"
+  end
+
+  def read(input, options = {})
+    reader = SmarterCSV::Reader.new(StringIO.new(input), options)
+    [reader.process, reader.headers]
+  end
+
+  def read_arrays(input, options = {})
+    rows, headers = read(input, options.merge(rows_as: :arrays))
+    [rows.map { |row| row + [nil] * (headers.size - row.size) }, headers]
+  end
+
+  def expected(input, options = {})
+    rows, headers = read(input, options)
+    [rows.map { |hash| hash.values_at(*headers) }, headers]
+  end
+
+  [
+    {},
+    { remove_empty_values: false },
+    { remove_zero_values: true },
+    { remove_empty_hashes: false },
+    { convert_values_to_numeric: { only: %i[id flag] } },
+    { headers: { only: %i[id name] } },
+    { headers: { except: %i[amount column_6] } },
+    { key_mapping: { notes: nil } },
+    { nil_values_matching: /\ANA\z/ },
+    { nil_values_matching: /\ANA\z/, remove_empty_values: false },
+    { value_converters: { name: ->(v) { v.upcase }, column_6: ->(v) { v.to_sym } } },
+    { value_converters: { notes: ->(v) { v.inspect } }, remove_empty_values: false },
+    { parallel: 2 },
+    { acceleration: false },
+    { acceleration: false, headers: { only: %i[id name] } },
+  ].each do |options|
+    it "matches the hash rows with #{options.inspect}" do
+      expect(read_arrays(csv, options)).to eq expected(csv, options)
+    end
+  end
+
+  it 'matches the hash rows on the line loop' do
+    options = { comment_regexp: /\A#/ }
+    expect(read_arrays(csv, options)).to eq expected(csv, options)
+  end
+
+  it 'pads every row to the headers known so far and keeps extra columns' do
+    rows, headers = read(csv, rows_as: :arrays)
+    expect(headers).to eq %i[id amount name notes flag column_6]
+    expect(rows[0]).to eq [1, 12.5, 'alice', "multi\nline", 0]
+    expect(rows[2]).to eq [3, nil, 'carol "c"', 'x', 0, 'extra']
+    expect(rows.last).to eq [5, nil, nil, nil, nil, nil]
+  end
+
+  it 'yields chunks of Arrays' do
+    chunks = []
+    SmarterCSV.process(StringIO.new(csv), rows_as: :arrays, chunk_size: 2) { |chunk| chunks << chunk.dup }
+    expect(chunks.flatten(1)).to eq read(csv, rows_as: :arrays).first
+  end
+
+  it 'rejects an unknown value and conflicting options' do
+    expect { SmarterCSV.process(StringIO.new(csv), rows_as: :tuples) }.to raise_error(SmarterCSV::ValidationError, /rows_as/)
+    expect { SmarterCSV.process(StringIO.new(csv), rows_as: :arrays, with_line_numbers: true) }
+      .to raise_error(SmarterCSV::ValidationError, /with_line_numbers/)
+    expect { SmarterCSV.process(StringIO.new(csv), rows_as: :arrays, result_format: :columnar) }
+      .to raise_error(SmarterCSV::ValidationError, /columnar/)
+  end
+end
@@ -0,0 +1,25 @@
+# frozen_string_literal: true
+
+# The C extension picks its SIMD kernels (quote/backslash scan, structural indexer) once
+# at load time from what the CPU reports. Whatever it picked must parse exactly like the
+# Ruby implementation — the kernels only change how fast boundaries are found.
+
+describe 'SIMD kernel dispatch' do
+  it 'reports the kernel set picked at load time' do
+    skip 'C extension not loaded' unless SmarterCSV::Parser.respond_to?(:simd_level_c)
+
+    level = SmarterCSV::Parser.simd_level_c
+    expect(%w[avx512bw avx2 sse2 neon scalar]).to include(level)
+    expect(level).to be_frozen
+  end
+
+  [:double_quotes, :backslash].each do |quote_escaping|
+    it "parses long quoted fields like the Ruby path with quote_escaping: #{quote_escaping}" do
+      content = ('abc,def ' * 40) + '""' + ('x' * 70) + '\\' + ('y' * 33)
+      csv = "a,b,c\n\"#{content}\",\"#{'z' * 129}\",plain\n"
+      c_data    = SmarterCSV.process(StringIO.new(csv), acceleration: true,  quote_escaping: quote_escaping)
+      ruby_data = SmarterCSV.process(StringIO.new(csv), acceleration: false, quote_escaping: quote_escaping)
+      expect(c_data).to eq ruby_data
+    end
+  end
+end
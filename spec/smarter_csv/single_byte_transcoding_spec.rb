@@ -0,0 +1,89 @@
+# frozen_string_literal: true
+
+require 'tmpdir'
+require 'fileutils'
+
+# Single-byte input (ISO-8859-x, Windows-125x, ...) read as UTF-8 is transcoded by the block
+# reader in C with a table built from Ruby's converter, instead of by IO#gets or
+# enforce_utf8_encoding one line at a time. The rows, and the errors, must be exactly those
+# of the line loop.
+
+describe 'single-byte transcoding in the block reader' do
+  before do
+    skip 'C extension not available' unless SmarterCSV::Parser.respond_to?(:block_reader_transcode_c)
+  end
+
+  let(:dir) { Dir.mktmpdir }
+  after { FileUtils.remove_entry(dir) }
+
+  let(:high_bytes) { (0x80..0xFF).map(&:chr).join }
+  let(:csv) do
+    rows = (1..3_000).map { |i| "#{i},caf\xE9 #{i},\"\x93quoted\x94\n".b + high_bytes[i % 128, 9] + "\",#{i * 0.5}" }
+    "id,name,note,amount\r\n#{rows.join("\r\n")}\r\n".b
+  end
+
+  def write(content, name = 'data.csv')
+    File.join(dir, name).tap { |path| File.binwrite(path, content.b) }
+  end
+
+  def both(path, options)
+    [SmarterCSV.process(path, options), SmarterCSV.process(path, options.merge(acceleration: false))]
+  end
+
+  %w[iso-8859-1 windows-1252 windows-1250 koi8-r].each do |encoding|
+    ['', '?', '¿'].each do |replacement|
+      it "reads #{encoding} with invalid_byte_sequence: #{replacement.inspect} like the line loop" do
+        c_rows, ruby_rows = both(write(csv), file_encoding: encoding, invalid_byte_sequence: replacement)
+        expect(c_rows).to eq ruby_rows
+        expect(c_rows.flat_map(&:values).grep(String)).to all(satisfy { |s| s.encoding == Encoding::UTF_8 && s.valid_encoding? })
+      end
+    end
+  end
+
+  it 'transcodes a File opened with an internal encoding like IO#gets' do
+    path = write(csv.delete("\x81\x8D\x8F\x90\x9D".b))
+    c_rows, ruby_rows = both(path, file_encoding: 'windows-1252:utf-8')
+    expect(c_rows).to eq ruby_rows
+    expect(c_rows[0][:name]).to eq 'café 1'
+    expect(c_rows[0][:note]).to start_with '“quoted”'
+  end
+
+  it 'raises like IO#gets on a byte without a UTF-8 form' do
+    path = write("id,name\n1,ok\n2,\x81\n")
+    expect { SmarterCSV.process(path, file_encoding: 'windows-1252:utf-8') }
+      .to raise_error(Encoding::UndefinedConversionError, '"\x81" to UTF-8 in conversion from Windows-1252 to UTF-8')
+  end
+
+  it 'transcodes gzip input' do
+    require 'zlib'
+    path = File.join(dir, 'data.csv.gz')
+    Zlib::GzipWriter.open(path) { |gz| gz.write(csv) }
+    expect(SmarterCSV.process(path, file_encoding: 'windows-1252'))
+      .to eq SmarterCSV.process(write(csv), file_encoding: 'windows-1252', acceleration: false)
+  end
+
+  it 'keeps checkpoints in terms of the input bytes' do
+    path = write(csv)
+    options = { file_encoding: 'windows-1252', invalid_byte_sequence: '¿', chunk_size: 700 }
+    full = []
+    SmarterCSV::Reader.new(path, options).each_chunk { |chunk, index| full << [index, chunk] }
+
+    resumed = []
+    token = nil
+    reader = SmarterCSV::Reader.new(path, options)
+    reader.each_chunk do |chunk, index|
+      resumed << [index, chunk]
+      token = reader.checkpoint.dump
+      break if index == 1
+    end
+    expect(reader.checkpoint.offset).to eq csv.b.index("\r\n1401,") + 2
+    SmarterCSV::Reader.new(path, options.merge(resume_from: token)).each_chunk { |chunk, index| resumed << [index, chunk] }
+    expect(resumed).to eq full
+  end
+
+  it 'leaves multi-byte encodings to the line loop' do
+    reader = SmarterCSV::Reader.allocate
+    expect(reader.send(:single_byte_table, Encoding::Shift_JIS)).to be_nil
+    expect(reader.send(:single_byte_table, Encoding::Windows_1252).bytesize).to eq 1_024
+  end
+end
@@ -0,0 +1,131 @@
+# frozen_string_literal: true
+
+# SmarterCSV::StreamBuffer is the C counterpart of PeekableIO: with the C extension, a
+# non-seekable input is buffered by it instead. It must hand out exactly the bytes PeekableIO
+# would — BOM stripped on peek, the peek ending on a whole character, replay after
+# rewind_buffer — with lines found in one C buffer instead of a Ruby String per chunk.
+
+describe SmarterCSV::StreamBuffer do
+  before do
+    skip 'C extension not available' unless SmarterCSV::Parser.respond_to?(:new_stream_buffer_c)
+  end
+
+  def pipe_of(content, encoding = 'utf-8')
+    r, w = IO.pipe
+    r.set_encoding(encoding)
+    writer = Thread.new do
+      w.binmode
+      w.write(content)
+      w.close
+    end
+    [r, writer]
+  end
+
+  # runs the same calls against a StreamBuffer and a PeekableIO over the same content
+  def both(content, buffer_size: 4096, encoding: 'utf-8')
+    [
+      ->(io) { SmarterCSV::Parser.new_stream_buffer_c(io, buffer_size) },
+      ->(io) { SmarterCSV::PeekableIO.new(io, {}, buffer_size: buffer_size) },
+    ].map do |wrap|
+      r, writer = pipe_of(content, encoding)
+      result = yield wrap.call(r)
+      writer.join
+      r.close
+      result
+    end
+  end
+
+  let(:csv) do
+    rows = (1..5_000).map { |i| "#{i},Zürich #{i},\"quoted, #{i}\"" }
+    "\xEF\xBB\xBFid,city,notes\r\n#{rows.join("\r\n")}\r\n".b
+  end
+
+  it 'peeks, replays and reads lines like PeekableIO' do
+    results = both(csv) do |buf|
+      peeked = buf.peek
+      first = buf.gets("\r\n")
+      buf.rewind_buffer
+      buf.freeze_buffer!
+      lines = []
+      while (line = buf.gets("\r\n"))
+        lines << line
+      end
+      [peeked, first, lines, buf.eof?]
+    end
+    expect(results[0]).to eq results[1]
+    expect(results[0][1]).to eq "id,city,notes\r\n"
+    expect(results[0][2].size).to eq 5_001
+    expect(results[0][2].map(&:encoding).uniq).to eq [Encoding::UTF_8]
+  end
+
+  it 'ends the peek on a whole character' do
+    content = "#{'a' * 4095}ü,b\n1,2\n"
+    results = both(content) { |buf| buf.peek }
+    expect(results[0]).to eq results[1]
+    expect(results[0].bytesize).to eq 4097
+    expect(results[0]).to be_valid_encoding
+  end
+
+  it 'keeps bytes read during detection for replay' do
+    results = both(csv) do |buf|
+      buf.peek
+      detected = buf.read(10_000)
+      buf.rewind_buffer
+      buf.freeze_buffer!
+      [detected, buf.read(12_000), buf.read(1_000_000), buf.read(10)]
+    end
+    expect(results[0]).to eq results[1]
+    expect(results[0][1]).to start_with(results[0][0])
+  end
+
+  it 'returns the last line without a separator' do
+    results = both("a,b\n1,2") do |buf|
+      buf.peek
+      buf.freeze_buffer!
+      [buf.gets("\n"), buf.gets("\n"), buf.gets("\n")]
+    end
+    expect(results[0]).to eq ["a,b\n", "1,2", nil]
+    expect(results[1]).to eq results[0]
+  end
+
+  it 'hands out what is buffered with drain_buffer' do
+    results = both(csv) do |buf|
+      buf.peek
+      buf.gets("\r\n")
+      buf.freeze_buffer!
+      buf.drain_buffer + buf.source.read.b
+    end
+    expect(results[0]).to eq results[1]
+    expect(results[0]).to eq csv.byteslice(3 + "id,city,notes\r\n".bytesize..)
+  end
+
+  it 'rejects gets(nil)' do
+    r, writer = pipe_of("a\n")
+    expect { SmarterCSV::Parser.new_stream_buffer_c(r, 4096).gets(nil) }.to raise_error(ArgumentError, /explicit separator/)
+    writer.join
+  end
+
+  context 'when reading a pipe' do
+    def read(content, options)
+      r, writer = pipe_of(content)
+      reader = SmarterCSV::Reader.new(r, options)
+      result = [reader.process, reader.headers, reader.file_line_count, reader.csv_line_count]
+      writer.join
+      result
+    end
+
+    [{}, { row_sep: "\r\n", col_sep: ',' }, { quote_boundary: :legacy, buffer_size: 4096 }].each do |options|
+      it "gives the rows of PeekableIO with #{options}" do
+        expect(read(csv, options)).to eq read(csv, options.merge(acceleration: false))
+      end
+    end
+
+    it 'is used with acceleration, PeekableIO without' do
+      wrapped = []
+      allow(SmarterCSV::PeekableIO).to receive(:new).and_wrap_original { |m, *args, **kw| wrapped << :ruby && m.call(*args, **kw) }
+      read(csv, {})
+      read(csv, acceleration: false)
+      expect(wrapped).to eq [:ruby]
+    end
+  end
+end
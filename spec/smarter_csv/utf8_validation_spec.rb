@@ -0,0 +1,88 @@
+# frozen_string_literal: true
+
+require 'tmpdir'
+require 'fileutils'
+
+# With force_utf8 (or binary input) the block reader validates the input as UTF-8 in C
+# and repairs only the invalid sequences it finds, instead of running every line through
+# enforce_utf8_encoding. The rows must be exactly those of the line loop: the same
+# replacement for the same maximal invalid subpart, wherever it falls in a block.
+
+describe 'UTF-8 validation in the block reader' do
+  before do
+    skip 'C extension not available' unless SmarterCSV::Parser.respond_to?(:block_reader_enforce_utf8_c)
+  end
+
+  let(:dir) { Dir.mktmpdir }
+  after { FileUtils.remove_entry(dir) }
+
+  def write(content)
+    File.join(dir, 'data.csv').tap { |path| File.binwrite(path, content.b) }
+  end
+
+  def both(content, options)
+    path = write(content)
+    [SmarterCSV.process(path, options), SmarterCSV.process(path, options.merge(acceleration: false))]
+  end
+
+  invalid = {
+    'a stray continuation byte' => "\x80",
+    'a byte that is never UTF-8' => "\xFF",
+    'an overlong encoding' => "\xC0\xAF",
+    'a surrogate' => "\xED\xA0\x80",
+    'a code point past U+10FFFF' => "\xF4\x90\x80\x80",
+    'a cut-off 4-byte sequence' => "\xF0\x9F\x98",
+    'a cut-off sequence before a lead byte' => "\xE2\x82\xC3\xA9",
+  }
+
+  let(:valid_rows) do
+    (1..2_000).map { |i| "#{i},Zürich #{i},“#{'€' * (i % 7)}”,#{'𝄞' * (i % 3)}" }
+  end
+
+  invalid.each do |what, bytes|
+    ['', '?', '¿'].each do |replacement|
+      it "replaces #{what} with #{replacement.inspect} like the line loop" do
+        rows = valid_rows.dup
+        [3, 700, 1_999].each { |i| rows[i] = "#{i + 1},bad#{bytes}x,#{bytes},#{bytes}#{bytes}" }
+        c_rows, ruby_rows = both("id,city,note,clef\n#{rows.join("\n")}\n#{bytes}", force_utf8: true, invalid_byte_sequence: replacement)
+        expect(c_rows).to eq ruby_rows
+        expect(c_rows[3][:city]).to eq "bad#{bytes}x".dup.force_encoding('utf-8').encode('utf-8', invalid: :replace, replace: replacement)
+        expect(c_rows.flat_map(&:values).grep(String)).to all(be_valid_encoding)
+      end
+    end
+  end
+
+  it 'repairs sequences cut by the end of a read block' do
+    block = SmarterCSV::Reader::BLOCK_READ_SIZE
+    filler = (1..(block / 40)).map { |i| "#{i},#{'y' * 32}" }.join("\n")
+    [-3, -2, -1, 0, 1].each do |shift|
+      ["\xE2\x82\xAC", "\xF0\x9F\x98\x80", "\xE2\x82", "\xFF"].each do |bytes|
+        head = "id,name\n#{filler}\n0,"
+        content = head + ('z' * (block + shift - head.bytesize)) + bytes + "tail\n1,end\n"
+        c_rows, ruby_rows = both(content, force_utf8: true, invalid_byte_sequence: '?')
+        expect(c_rows).to eq ruby_rows
+      end
+    end
+  end
+
+  it 'tags binary input as UTF-8 like the line loop' do
+    c_rows, ruby_rows = both("id,name\n1,caf\xC3\xA9\n2,caf\xE9\n", file_encoding: 'binary')
+    expect(c_rows).to eq ruby_rows
+    expect(c_rows.map { |h| h[:name] }).to eq %w[café caf]
+    expect(c_rows[0][:name].encoding).to eq Encoding::UTF_8
+  end
+
+  it 'keeps bad-row records and checkpoints in terms of the input bytes' do
+    path = write("id,name\n1,\xFFa\n2,\"open\xFF\n")
+    reader = SmarterCSV::Reader.new(path, force_utf8: true, invalid_byte_sequence: '?', on_bad_row: :collect, chunk_size: 1)
+    offsets = []
+    reader.each_chunk { offsets << reader.checkpoint.offset }
+    expect(offsets).to eq ["id,name\n1,\xFFa\n".bytesize]
+    expect(reader.errors[:bad_rows].first[:raw_logical_line]).to eq "2,\"open?\n"
+  end
+
+  it 'leaves a replacement that could end a field to the line loop' do
+    c_rows, ruby_rows = both("id,name\n1,a\xFFb\n", force_utf8: true, invalid_byte_sequence: ',')
+    expect(c_rows).to eq ruby_rows
+  end
+end